@@ -1,3 +1,7 @@
+// Count allocations in this program when built with REACTIF_PROFILE
+#define REACTIF_PROFILE_HOOKS
+#include <cstdio>
+#include <cstdlib>
 #include <reactif/reactif.hpp>
 
 using namespace rf;
@@ -23,6 +27,19 @@ class MyApplication : public Application<Message> {
             break;
         }
     }
+    std::optional<MessageCodec<Message>> codec() const override {
+        return MessageCodec<Message>{
+            [](const Message &m, std::string &out) { out += (char)m; },
+            [](std::string_view in) -> std::optional<Message> {
+                if (in.size() != 1)
+                    return std::nullopt;
+                return (Message)in[0];
+            },
+        };
+    }
+    void on_replay(const ReplayReport &report) override {
+        std::fputs(report.report().c_str(), stdout);
+    }
     std::shared_ptr<Widget<Message>> view() override {
         return flex()
             .column()
@@ -31,17 +48,17 @@ class MyApplication : public Application<Message> {
                 button()
                     .label("Increment")
                     .fixed(40)
-                    .on_trigger(TRIGGER(Message::Increment))
+                    .on_trigger(Message::Increment)
                     .create(),
                 box()
-                    .label(std::to_string(value))
+                    .label_fmt("%d", value)
                     .labeltype(LabelType::Engraved)
                     .labelsize(20)
                     .create(),
                 button()
                     .label("Decrement")
                     .fixed(40)
-                    .on_trigger(TRIGGER(Message::Decrement))
+                    .on_trigger(Message::Decrement)
                     .create(),
             })
             .create();
@@ -49,6 +66,15 @@ class MyApplication : public Application<Message> {
 };
 
 int main(int argc, char **argv) {
-    MyApplication app({ .size = std::pair(400, 300) });
+    Settings settings{.size = std::pair(400, 300)};
+    // Record a session, then replay it as a benchmark
+    if (auto *path = std::getenv("COUNTER_RECORD"))
+        settings.record_path = path;
+    if (auto *path = std::getenv("COUNTER_REPLAY"))
+        settings.replay_path = path;
+    // Write a trace that Perfetto can open
+    if (auto *path = std::getenv("COUNTER_TRACE"))
+        settings.trace_path = path;
+    MyApplication app(std::move(settings));
     app.run(argc, argv);
 }
\ No newline at end of file
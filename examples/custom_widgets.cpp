@@ -2,6 +2,8 @@
 #include <FL/fl_draw.H>
 #include <reactif/reactif.hpp>
 #include <FL/Fl_Box.H>
+#include <cstdio>
+#include <cstdlib>
 
 /// This example shows two ways of wrapping a widget derived from an FLTK widget
 
@@ -95,7 +97,7 @@ class MyApplication : public Application<Message> {
             .column()
             .margins(40)
             .children({
-                mybox1().create(),
+                mybox1().key("mybox1").create(),
                 mybox2().create(),
             })
             .create();
@@ -103,6 +105,10 @@ class MyApplication : public Application<Message> {
 };
 
 int main(int argc, char **argv) {
-    MyApplication app({ .size = std::pair(400, 300) });
+    // Report which widgets cost the most to draw once the window is closed
+    auto profile = std::getenv("CUSTOM_WIDGETS_PROFILE") != nullptr;
+    MyApplication app({ .size = std::pair(400, 300), .profile_draws = profile });
     app.run(argc, argv);
+    if (profile)
+        std::fputs(app.draw_profile().report().c_str(), stdout);
 }
\ No newline at end of file
@@ -43,7 +43,7 @@ class MyApplication : public Application<Message> {
                     .labelfont(Font::Times)
                     .create(),
                 box()
-                    .label(std::to_string(value))
+                    .label_fmt("%d", value)
                     .align(Align::Top | Align::Inside)
                     .labelsize(36)
                     .labelcolor(GRAY)
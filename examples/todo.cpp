@@ -7,53 +7,58 @@ struct Message {
     std::string value;
     static Message add_task(std::string val) { return {NewTask, val}; }
     static Message remove_task(std::string val) { return {RemoveTask, val}; }
+    bool operator==(const Message &) const = default;
 };
 
 class MyApplication : public Application<Message> {
     int value                          = 0;
     std::shared_ptr<std::string> inval = std::make_shared<std::string>();
-    std::vector<std::string> tasks;
+    PersistentVector<std::string> tasks;
+    ChunkMemo<std::shared_ptr<Widget<Message>>> rows;
 
   public:
     MyApplication(Settings &&settings) : Application(std::move(settings)) {}
     std::string title() const override { return "TodoApp"; }
-    void update(const Message &m) override {
+    Changed reduce(const Message &m) override {
         auto val = m.value;
         if (val.empty())
-            return;
+            return Changed::None;
         switch (m.op) {
         case Message::NewTask:
-            tasks.push_back(val);
+            tasks = tasks.push_back(val);
             break;
         case Message::RemoveTask: {
             auto idx = std::find(tasks.begin(), tasks.end(), val);
-            tasks.erase(idx);
+            if (idx != tasks.end())
+                tasks = tasks.erase((size_t)std::distance(tasks.begin(), idx));
+            else
+                return Changed::None;
             break;
         }
         }
+        return Changed::All;
     }
     std::shared_ptr<Widget<Message>> view() override {
-        auto p     = pack().vertical();
-        auto boxes = std::vector<std::shared_ptr<Widget<Message>>>();
-        for (const auto &t : tasks) {
-            auto f = flex()
-                         .row()
-                         .size(0, 30)
-                         .children({
-                             box()
-                                 .label(t)
-                                 .align(Align::Left | Align::Inside)
-                                 .create(),
-                             check_button()
-                                 .fixed(30)
-                                 .align(Align::Left | Align::Inside)
-                                 .value(true)
-                                 .on_trigger(TRIGGER(Message::remove_task(t)))
-                                 .create(),
-                         })
-                         .create();
-            boxes.push_back(f);
-        }
+        auto p = pack().vertical();
+        // Rows are only rebuilt for the chunks of tasks that changed
+        auto boxes = rows.build(tasks, [this](const std::string &t, size_t) {
+            return flex()
+                .row()
+                .size(0, 30)
+                .children({
+                    box()
+                        .label(t)
+                        .align(Align::Left | Align::Inside)
+                        .create(),
+                    check_button()
+                        .fixed(30)
+                        .align(Align::Left | Align::Inside)
+                        .value(true)
+                        .on_trigger(Message::remove_task(t))
+                        .create(),
+                })
+                .create();
+        });
         p.children(boxes);
         return flex()
             .column()
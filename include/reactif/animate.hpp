@@ -0,0 +1,226 @@
+#pragma once
+
+#include "enums.hpp"
+#include <FL/Fl.H>
+#include <FL/Fl_Valuator.H>
+#include <FL/Fl_Widget.H>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rf {
+
+/// A widget property that can be animated
+enum class Prop {
+    Color,
+    Position,
+    Size,
+    /// The value of a valuator
+    Value,
+};
+
+/// How an animation's progress follows time
+enum class Easing {
+    Linear,
+    EaseIn,
+    EaseOut,
+    EaseInOut,
+};
+
+/// Where an animation ends: a color, a position or size, or a value
+class AnimationTarget {
+    std::array<double, 3> v_ = {};
+
+  public:
+    AnimationTarget(Color c) : v_{(double)(std::uint32_t)c, 0, 0} {}
+    AnimationTarget(Color::Predef c) : AnimationTarget(Color(c)) {}
+    AnimationTarget(std::pair<int, int> p)
+        : v_{(double)p.first, (double)p.second, 0} {}
+    AnimationTarget(double value) : v_{value, 0, 0} {}
+    [[nodiscard]] const std::array<double, 3> &values() const { return v_; }
+};
+
+/// A property tweened from its current value to a target
+struct Animation {
+    Prop prop;
+    std::array<double, 3> target;
+    double secs;
+    Easing easing;
+    bool operator==(const Animation &) const = default;
+};
+
+namespace detail {
+
+/// Runs every tween of the application off a single frame timer, writing
+/// the properties straight to the FLTK widgets. Messages, view() and
+/// diffing are not involved.
+class Animator {
+    using Clock  = std::chrono::steady_clock;
+    using Values = std::array<double, 3>;
+    struct Tween {
+        /// Watched, so FLTK clears it when the widget is deleted
+        Fl_Widget *w;
+        Prop prop;
+        Values from;
+        Values to;
+        Values now;
+        /// The target of a color tween, which may be an indexed color
+        Fl_Color color;
+        Clock::time_point start;
+        double secs;
+        Easing easing;
+    };
+    std::vector<std::unique_ptr<Tween>> tweens_;
+
+    static double ease(Easing e, double p) {
+        switch (e) {
+        case Easing::EaseIn:
+            return p * p * p;
+        case Easing::EaseOut:
+            return 1 - std::pow(1 - p, 3);
+        case Easing::EaseInOut:
+            return p < 0.5 ? 4 * p * p * p : 1 - std::pow(2 - 2 * p, 3) / 2;
+        default:
+            return p;
+        }
+    }
+    static Values rgb(Fl_Color c) {
+        unsigned char r = 0, g = 0, b = 0;
+        Fl::get_color(c, r, g, b);
+        return {(double)r, (double)g, (double)b};
+    }
+    static Values read(Fl_Widget *w, Prop prop) {
+        switch (prop) {
+        case Prop::Color:
+            return rgb(w->color());
+        case Prop::Position:
+            return {(double)w->x(), (double)w->y(), 0};
+        case Prop::Size:
+            return {(double)w->w(), (double)w->h(), 0};
+        default:
+            return {static_cast<Fl_Valuator *>(w)->value(), 0, 0};
+        }
+    }
+    static void write(Fl_Widget *w, Prop prop, const Values &v) {
+        auto px = [](double d) { return (int)std::lround(d); };
+        auto ch = [](double d) {
+            return (unsigned char)std::clamp(std::lround(d), 0L, 255L);
+        };
+        switch (prop) {
+        case Prop::Color:
+            w->color(fl_rgb_color(ch(v[0]), ch(v[1]), ch(v[2])));
+            w->redraw();
+            break;
+        case Prop::Position:
+        case Prop::Size:
+            if (prop == Prop::Position)
+                w->position(px(v[0]), px(v[1]));
+            else
+                w->size(px(v[0]), px(v[1]));
+            // The old rectangle needs repainting as well
+            if (w->parent())
+                w->parent()->redraw();
+            else
+                w->redraw();
+            break;
+        default:
+            static_cast<Fl_Valuator *>(w)->value(v[0]);
+            break;
+        }
+    }
+    static void tick_cb(void *data) { ((Animator *)data)->tick(); }
+    void tick() {
+        auto now = Clock::now();
+        for (std::size_t i = 0; i < tweens_.size();) {
+            auto &t = *tweens_[i];
+            if (!t.w) {
+                remove(i);
+                continue;
+            }
+            auto secs = std::chrono::duration<double>(now - t.start).count();
+            auto p    = t.secs > 0 ? std::min(secs / t.secs, 1.0) : 1.0;
+            auto e    = ease(t.easing, p);
+            for (std::size_t j = 0; j < t.now.size(); j++)
+                t.now[j] = t.from[j] + (t.to[j] - t.from[j]) * e;
+            write(t.w, t.prop, t.now);
+            if (p < 1) {
+                i++;
+                continue;
+            }
+            if (t.prop == Prop::Color)
+                t.w->color(t.color);
+            remove(i);
+        }
+        if (!tweens_.empty())
+            Fl::repeat_timeout(frame_secs, tick_cb, this);
+    }
+    void remove(std::size_t i) {
+        Fl::release_widget_pointer(tweens_[i]->w);
+        tweens_[i] = std::move(tweens_.back());
+        tweens_.pop_back();
+    }
+    Tween *find(Fl_Widget *w, Prop prop) {
+        for (auto &t : tweens_)
+            if (t->w == w && t->prop == prop)
+                return t.get();
+        return nullptr;
+    }
+
+  public:
+    static constexpr double frame_secs = 1.0 / 60;
+    Animator() = default;
+    Animator(const Animator &)            = delete;
+    Animator &operator=(const Animator &) = delete;
+    ~Animator() {
+        Fl::remove_timeout(tick_cb, this);
+        while (!tweens_.empty())
+            remove(tweens_.size() - 1);
+    }
+    static Animator &global() {
+        static Animator animator;
+        return animator;
+    }
+    /// Tween a property of w to a's target. A tween already running on the
+    /// same property is retargeted from where it has got to.
+    void start(Fl_Widget *w, const Animation &a) {
+        if (a.prop == Prop::Value && !dynamic_cast<Fl_Valuator *>(w))
+            return;
+        auto *t = find(w, a.prop);
+        if (!t) {
+            tweens_.push_back(std::make_unique<Tween>());
+            t      = tweens_.back().get();
+            t->w   = w;
+            t->now = read(w, a.prop);
+            Fl::watch_widget_pointer(t->w);
+        }
+        t->prop   = a.prop;
+        t->from   = t->now;
+        t->to     = a.target;
+        t->color  = (Fl_Color)a.target[0];
+        t->start  = Clock::now();
+        t->secs   = a.secs;
+        t->easing = a.easing;
+        if (a.prop == Prop::Color)
+            t->to = rgb(t->color);
+        if (!Fl::has_timeout(tick_cb, this))
+            Fl::add_timeout(frame_secs, tick_cb, this);
+    }
+    /// Leave w's property where a running tween has got it to
+    void stop(Fl_Widget *w, Prop prop) {
+        for (std::size_t i = 0; i < tweens_.size(); i++) {
+            if (tweens_[i]->w == w && tweens_[i]->prop == prop) {
+                remove(i);
+                return;
+            }
+        }
+    }
+    /// The number of tweens running
+    [[nodiscard]] std::size_t running() const { return tweens_.size(); }
+};
+} // namespace detail
+} // namespace rf
@@ -27,6 +27,7 @@ class BrowserItem {
     /// Get the width of the item
     [[nodiscard]] int width() const { return width_; }
     bool operator==(const BrowserItem &) const = default;
+    void hash(Hasher &h) const { h(label_, width_); }
     void view(Fl_Browser *m) const { m->add(label_.c_str()); }
     void update(Fl_Browser *w, const BrowserItem &other) {
         w->add(label_.c_str());
@@ -42,6 +43,7 @@ struct BrowserProps {
     std::optional<int> topline;
     std::optional<int> middleline;
     std::optional<int> bottomline;
+    /// Column widths handed to FLTK, derived from the items
     std::vector<int> widths;
     void view(B *w) {
         if (!items.empty()) {
@@ -69,6 +71,7 @@ struct BrowserProps {
         if (other.items != items) {
             w->clear();
             items = other.items;
+            widths.clear();
             for (auto i = 0; i < items.size(); i++) {
                 items[i].update(w, other.items[i]);
                 widths.push_back(items[i].width());
@@ -109,13 +112,31 @@ struct BrowserProps {
                 w->bottomline(*bottomline);
         }
     }
-    bool operator==(const BrowserProps &) const = default;
+    /// Compares what hash() hashes, leaving out the derived widths
+    bool operator==(const BrowserProps &other) const {
+        return items == other.items && column_char == other.column_char &&
+               textsize == other.textsize && select == other.select &&
+               topline == other.topline && middleline == other.middleline &&
+               bottomline == other.bottomline;
+    }
+    void hash(Hasher &h) const {
+        h(items, column_char, textsize, select);
+        h(topline, middleline, bottomline);
+    }
 };
 
 template <class Message, class W, class B>
 class BrowserBase : public WidgetBase<Message, W, B> {
   protected:
     BrowserProps<Message, B> bprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        bprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               bprops == other.bprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
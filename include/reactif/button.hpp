@@ -1,5 +1,6 @@
 #pragma once
 
+#include "handler.hpp"
 #include "widget.hpp"
 #include <FL/Fl_Button.H>
 #include <FL/Fl_Check_Button.H>
@@ -18,18 +19,24 @@ struct ButtonProps {
     std::optional<bool> value;
     std::optional<Shortcut> shortcut;
     std::optional<BoxType> downbox;
-    std::optional<std::shared_ptr<std::function<Message()>>> on_trigger;
+    Handler<Message> on_trigger;
+    /// Send the handler currently in the props, so that updating them
+    /// rebinds the callback
+    void bind(B *w) {
+        static_cast<FlWidgetWrapper<B> *>(w)->cb([data = &on_trigger](auto *) {
+            if (*data)
+                Fl::awake((void *)data);
+        });
+    }
     void view(B *w) {
         if (value)
             w->value(*value);
         if (downbox)
-            w->down_box((Fl_Boxtype)*downbox);
+            w->down_box(boxtype(*downbox));
         if (shortcut)
             w->shortcut(*shortcut);
         if (on_trigger)
-            static_cast<FlWidgetWrapper<B> *>(w)->cb(
-                [data = on_trigger->get()](auto *) { Fl::awake(data); }
-            );
+            bind(w);
     }
     void update(B *w, const ButtonProps &other) {
         if (*this == other)
@@ -47,16 +54,31 @@ struct ButtonProps {
         if (other.downbox != downbox) {
             downbox = other.downbox;
             if (downbox)
-                w->down_box((Fl_Boxtype)*downbox);
+                w->down_box(boxtype(*downbox));
+        }
+        if (other.on_trigger != on_trigger) {
+            bool bound = (bool)on_trigger;
+            on_trigger = other.on_trigger;
+            if (on_trigger && !bound)
+                bind(w);
         }
     }
     bool operator==(const ButtonProps &) const = default;
+    void hash(Hasher &h) const { h(value, shortcut, downbox, on_trigger); }
 };
 
 template <class Message, class W, class B>
 class ButtonBase : public WidgetBase<Message, W, B> {
   protected:
     ButtonProps<Message, B> bprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        bprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               bprops == other.bprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -88,10 +110,10 @@ class ButtonBase : public WidgetBase<Message, W, B> {
         bprops.shortcut = b;
         return *(W *)this;
     }
-    /// Set the button's callback message
-    W &on_trigger(std::function<Message()> &&msg) {
-        bprops.on_trigger =
-            std::make_shared<std::function<Message()>>(std::move(msg));
+    /// Set the message sent when the button is triggered, or a closure
+    /// producing it
+    W &on_trigger(Handler<Message> msg) {
+        bprops.on_trigger = std::move(msg);
         return *(W *)this;
     }
 };
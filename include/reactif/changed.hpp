@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace rf {
+
+/// Which regions of an application's state a message changed, returned by
+/// Application::reduce(). Applications number their own regions with
+/// changed_region(), up to 64 of them.
+enum class Changed : std::uint64_t {
+    None = 0,
+    All  = ~std::uint64_t(0),
+};
+
+constexpr Changed operator|(Changed a, Changed b) {
+    return Changed((std::uint64_t)a | (std::uint64_t)b);
+}
+constexpr Changed operator&(Changed a, Changed b) {
+    return Changed((std::uint64_t)a & (std::uint64_t)b);
+}
+constexpr Changed operator~(Changed a) { return Changed(~(std::uint64_t)a); }
+constexpr Changed &operator|=(Changed &a, Changed b) { return a = a | b; }
+constexpr Changed &operator&=(Changed &a, Changed b) { return a = a & b; }
+
+/// The region of state numbered n, from 0 to 63
+constexpr Changed changed_region(unsigned n) {
+    return Changed(std::uint64_t(1) << n);
+}
+
+/// Whether a and b share a region
+constexpr bool overlaps(Changed a, Changed b) {
+    return (a & b) != Changed::None;
+}
+
+/// Keeps a subtree, or anything else built by view(), until a message
+/// changes one of the regions it reads. A kept node is the same pointer
+/// as before, which the reconciler skips. Because the memo holds it, the
+/// reconciler mounts a rebuilt node as it is rather than copying its props
+/// into the mounted one, so the kept node is never updated in place.
+template <class T>
+class RegionMemo {
+    Changed reads_;
+    std::optional<T> value_;
+
+  public:
+    explicit RegionMemo(Changed reads = Changed::All) : reads_(reads) {}
+    /// The kept value, built again with build() if changed overlaps the
+    /// regions it reads
+    template <class F>
+    const T &get(Changed changed, F &&build) {
+        if (!value_ || overlaps(changed, reads_))
+            value_ = std::forward<F>(build)();
+        return *value_;
+    }
+    void clear() { value_.reset(); }
+};
+} // namespace rf
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "pool.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "widget.hpp"
+#include <FL/Fl.H>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <typeinfo>
+#include <vector>
+
+namespace rf::detail {
+
+/// One node to bring up to date, found by TreeDiff::run()
+template <class Message>
+struct Patch {
+    enum Kind {
+        /// Update the node and everything below it
+        Full,
+        /// Update only the node's own props, which differ; its children have
+        /// patches of their own
+        Shallow,
+        /// Only refresh the node's hash and cached drawing: its own props
+        /// are unchanged and its children have patches of their own
+        Refresh,
+    };
+    Kind kind;
+    Widget<Message> *node;
+    Widget<Message> *next;
+};
+
+/// The patches of one subtree, in the order they must be applied
+template <class Message>
+struct PatchBuffer {
+    std::vector<Patch<Message>> patches;
+    /// Subtrees whose structural hash or props matched the mounted one
+    std::size_t skipped = 0;
+    /// Subtrees that were the mounted node itself
+    std::size_t reused = 0;
+
+    void append(PatchBuffer &&other) {
+        patches.insert(
+            patches.end(), other.patches.begin(), other.patches.end()
+        );
+        skipped += other.skipped;
+        reused += other.reused;
+    }
+};
+
+/// Whether the children a of a mounted node can be diffed pairwise with the
+/// children b of the next one: each pair is the same node or can be patched
+/// in place. Otherwise the parent is updated as a whole, which mounts the
+/// children that cannot. Hashes are left to the workers.
+template <class Message>
+bool pairwise(
+    std::span<const std::shared_ptr<Widget<Message>>> a,
+    std::span<const std::shared_ptr<Widget<Message>>> b
+) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](auto &x, auto &y) {
+               return x && y && (x == y || patchable(x, y));
+           });
+}
+
+/// Compares a mounted tree with the next one without touching FLTK, so
+/// sibling subtrees can be compared on the thread pool. Each task hashes
+/// the subtrees it was given, bottom-up, and compares the props of the
+/// nodes whose hashes differ, so that the UI thread is left with the
+/// patches of the nodes that changed, applied in order.
+template <class Message>
+class TreeDiff {
+    /// Below this depth subtrees are compared within a single task
+    static constexpr int parallel_depth = 4;
+
+    /// in_task is set inside pool tasks, the only place hashes are computed,
+    /// so no two threads fill in the same node's hash
+    static void diff(
+        Widget<Message> *cur,
+        Widget<Message> *next,
+        PatchBuffer<Message> &out,
+        int depth,
+        bool in_task
+    ) {
+        if (cur == next) {
+            out.reused++;
+            return;
+        }
+        if (in_task && same_hash(*cur, *next)) {
+            out.skipped++;
+            return;
+        }
+        auto a    = cur->child_nodes();
+        auto b    = next->child_nodes();
+        auto same = cur->props_equal(next);
+        if (a.empty() && b.empty()) {
+            if (same)
+                out.skipped++;
+            else
+                out.patches.push_back({Patch<Message>::Full, cur, next});
+            return;
+        }
+        if (!pairwise(a, b)) {
+            out.patches.push_back({Patch<Message>::Full, cur, next});
+            return;
+        }
+        auto below  = out.patches.size();
+        auto n      = a.size();
+        auto &pool  = ThreadPool::global();
+        auto chunks = std::min(n, pool.size() * 4);
+        if (in_task && depth >= parallel_depth)
+            chunks = 1;
+        if (chunks <= 1) {
+            for (std::size_t i = 0; i < n; i++)
+                diff(a[i].get(), b[i].get(), out, depth + 1, in_task);
+        } else {
+            // Each chunk writes its own buffer, merged back in child order
+            std::vector<PatchBuffer<Message>> buffers(chunks);
+            TaskGroup group(pool);
+            for (std::size_t c = 0; c < chunks; c++)
+                group.run([&, c] {
+                    REACTIF_TRACE_SCOPE("diff chunk");
+                    auto first = n * c / chunks;
+                    auto last  = n * (c + 1) / chunks;
+                    auto &buf  = buffers[c];
+                    for (auto i = first; i < last; i++)
+                        diff(a[i].get(), b[i].get(), buf, depth + 1, true);
+                });
+            group.wait();
+            for (auto &buffer : buffers)
+                out.append(std::move(buffer));
+        }
+        // After the children, which a Shallow update leaves alone
+        if (!same)
+            out.patches.push_back({Patch<Message>::Shallow, cur, next});
+        else if (out.patches.size() != below)
+            out.patches.push_back({Patch<Message>::Refresh, cur, next});
+        else
+            out.skipped++;
+    }
+
+  public:
+    /// The patches turning cur into next, which must have the same type
+    static PatchBuffer<Message>
+    run(Widget<Message> *cur, Widget<Message> *next) {
+        REACTIF_TRACE_SCOPE("diff");
+        PatchBuffer<Message> out;
+        diff(cur, next, out, 0, false);
+        return out;
+    }
+    /// Apply the patches of run(), on the UI thread
+    static void apply(const PatchBuffer<Message> &buffer) {
+        REACTIF_TRACE_SCOPE("apply patches");
+        for (const auto &p : buffer.patches) {
+            switch (p.kind) {
+            case Patch<Message>::Full:
+                p.node->update(p.next);
+                break;
+            case Patch<Message>::Shallow:
+                p.node->update_shallow(p.next);
+                break;
+            case Patch<Message>::Refresh:
+                p.node->refresh(p.next);
+                break;
+            }
+        }
+        if (!buffer.patches.empty())
+            Fl::redraw();
+        frame_stats().skipped_subtrees += buffer.skipped;
+        frame_stats().reused_subtrees += buffer.reused;
+    }
+};
+} // namespace rf::detail
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+namespace rf {
+
+/// Drawing done by the widgets sharing a key, or a type when they have none
+struct DrawCost {
+    std::string name;
+    /// Times draw() ran
+    std::size_t draws = 0;
+    /// Times a widget was created, or updated with different props
+    std::size_t changes = 0;
+    /// Time in draw(), not counting the widgets drawn inside it
+    double self_ms = 0;
+    /// Time in draw(), counting the widgets drawn inside it
+    double total_ms = 0;
+};
+
+/// Draw costs gathered while Settings::profile_draws is set, most expensive
+/// first
+struct DrawProfile {
+    std::vector<DrawCost> costs;
+
+    /// The n most expensive widgets by self time, one line each. Widgets
+    /// drawn far more often than they change stand out in the last column.
+    [[nodiscard]] std::string report(std::size_t n = 10) const {
+        std::string out;
+        char buf[256];
+        std::snprintf(
+            buf,
+            sizeof(buf),
+            "%-32s %10s %10s %8s %8s %10s\n",
+            "widget",
+            "self ms",
+            "total ms",
+            "draws",
+            "changes",
+            "draws/chg"
+        );
+        out += buf;
+        for (std::size_t i = 0; i < std::min(n, costs.size()); i++) {
+            const auto &c = costs[i];
+            std::snprintf(
+                buf,
+                sizeof(buf),
+                "%-32.32s %10.3f %10.3f %8zu %8zu %10.1f\n",
+                c.name.c_str(),
+                c.self_ms,
+                c.total_ms,
+                c.draws,
+                c.changes,
+                (double)c.draws / (double)std::max<std::size_t>(c.changes, 1)
+            );
+            out += buf;
+        }
+        return out;
+    }
+};
+
+namespace detail {
+
+/// A type name as written in the source, where the compiler can tell
+inline std::string demangle(const char *name) {
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    std::unique_ptr<char, void (*)(void *)> out(
+        abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free
+    );
+    if (status == 0 && out)
+        return out.get();
+#endif
+    return name;
+}
+
+/// Times the draw() of every FlWidgetWrapper while enabled, charging it to
+/// the widget's key or type. Only used on the UI thread.
+class DrawProfiler {
+    using Clock = std::chrono::steady_clock;
+    std::unordered_map<std::string, DrawCost> costs_;
+    bool enabled_ = false;
+    /// Time spent drawing widgets inside the draw in progress
+    Clock::duration children_{};
+
+    static double ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+  public:
+    static DrawProfiler &global() {
+        static DrawProfiler profiler;
+        return profiler;
+    }
+    [[nodiscard]] bool enabled() const { return enabled_; }
+    void enable(bool on) { enabled_ = on; }
+    /// The costs charged to a key or type, which stay at the same address
+    DrawCost &entry(std::string_view name) {
+        auto key = std::string(name);
+        auto it  = costs_.find(key);
+        if (it == costs_.end())
+            it = costs_.emplace(key, DrawCost{.name = key}).first;
+        return it->second;
+    }
+    /// Run draw, charging its time to cost
+    template <class F>
+    void time(DrawCost &cost, F &&draw) {
+        auto outer = children_;
+        children_  = {};
+        auto start = Clock::now();
+        draw();
+        auto total = Clock::now() - start;
+        cost.draws++;
+        cost.total_ms += ms(total);
+        cost.self_ms += ms(total - children_);
+        children_ = outer + total;
+    }
+    /// The costs so far, by decreasing self time
+    [[nodiscard]] DrawProfile snapshot() const {
+        DrawProfile p;
+        for (const auto &[name, cost] : costs_)
+            if (cost.draws || cost.changes)
+                p.costs.push_back(cost);
+        std::sort(p.costs.begin(), p.costs.end(), [](auto &a, auto &b) {
+            return a.self_ms > b.self_ms;
+        });
+        return p;
+    }
+    /// Zero the costs. Their entries are kept, since widgets point at them.
+    void reset() {
+        for (auto &[name, cost] : costs_)
+            cost = DrawCost{.name = name};
+    }
+};
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rf::detail {
+
+template <class Sig, std::size_t Capacity = 6 * sizeof(void *)>
+class InlineFunction;
+
+/// A copyable callable like std::function, which keeps closures of up to
+/// Capacity bytes inside itself instead of on the heap and has no
+/// reference count. Larger closures fall back to a heap allocation.
+/// Copies compare equal only to themselves, or when both are empty.
+template <class R, class... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+    struct Ops {
+        R (*call)(void *, Args &&...);
+        void (*copy)(const void *src, void *dst);
+        /// Move src into dst and end src's lifetime
+        void (*move)(void *src, void *dst);
+        void (*destroy)(void *);
+    };
+    template <class F>
+    static constexpr bool fits = sizeof(F) <= Capacity &&
+                                 alignof(F) <= alignof(std::max_align_t) &&
+                                 std::is_nothrow_move_constructible_v<F>;
+    /// Ops for a closure stored in the buffer
+    template <class F>
+    struct Inline {
+        static F &get(void *p) { return *static_cast<F *>(p); }
+        static R call(void *p, Args &&...args) {
+            return std::invoke(get(p), std::forward<Args>(args)...);
+        }
+        static void copy(const void *src, void *dst) {
+            new (dst) F(*static_cast<const F *>(src));
+        }
+        static void move(void *src, void *dst) {
+            new (dst) F(std::move(get(src)));
+            get(src).~F();
+        }
+        static void destroy(void *p) { get(p).~F(); }
+        static constexpr Ops ops = {call, copy, move, destroy};
+    };
+    /// Ops for a closure too large for the buffer, which holds a pointer
+    template <class F>
+    struct Boxed {
+        static F *&get(void *p) { return *static_cast<F **>(p); }
+        static R call(void *p, Args &&...args) {
+            return std::invoke(*get(p), std::forward<Args>(args)...);
+        }
+        static void copy(const void *src, void *dst) {
+            new (dst) F *(new F(**static_cast<F *const *>(src)));
+        }
+        static void move(void *src, void *dst) { new (dst) F *(get(src)); }
+        static void destroy(void *p) { delete get(p); }
+        static constexpr Ops ops = {call, copy, move, destroy};
+    };
+
+    alignas(std::max_align_t) mutable unsigned char buf_[Capacity];
+    const Ops *ops_ = nullptr;
+
+  public:
+    InlineFunction() = default;
+    InlineFunction(std::nullptr_t) {}
+    template <class F, class D = std::decay_t<F>>
+        requires(!std::is_same_v<D, InlineFunction> &&
+                 std::is_invocable_r_v<R, D &, Args...>)
+    InlineFunction(F &&f) {
+        if constexpr (fits<D>) {
+            new (buf_) D(std::forward<F>(f));
+            ops_ = &Inline<D>::ops;
+        } else {
+            new (buf_) D *(new D(std::forward<F>(f)));
+            ops_ = &Boxed<D>::ops;
+        }
+    }
+    InlineFunction(const InlineFunction &other) : ops_(other.ops_) {
+        if (ops_)
+            ops_->copy(other.buf_, buf_);
+    }
+    InlineFunction(InlineFunction &&other) noexcept : ops_(other.ops_) {
+        if (ops_)
+            ops_->move(other.buf_, buf_);
+        other.ops_ = nullptr;
+    }
+    InlineFunction &operator=(const InlineFunction &other) {
+        if (this != &other)
+            *this = InlineFunction(other);
+        return *this;
+    }
+    InlineFunction &operator=(InlineFunction &&other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_)
+                ops_->move(other.buf_, buf_);
+            other.ops_ = nullptr;
+        }
+        return *this;
+    }
+    ~InlineFunction() { reset(); }
+    void reset() {
+        if (ops_)
+            ops_->destroy(buf_);
+        ops_ = nullptr;
+    }
+    explicit operator bool() const { return ops_ != nullptr; }
+    R operator()(Args... args) const {
+        return ops_->call(buf_, std::forward<Args>(args)...);
+    }
+    bool operator==(const InlineFunction &other) const {
+        return this == &other || (!ops_ && !other.ops_);
+    }
+};
+} // namespace rf::detail
@@ -17,7 +17,10 @@ template <class Message, class B>
 struct GroupProps {
     std::vector<std::shared_ptr<Widget<Message>>> children;
     std::optional<int> fill;
+    bool cached = false;
     void view(B *w) {
+        if (cached)
+            static_cast<FlWidgetWrapper<B> *>(w)->cached(true);
         if (fill) {
             static_cast<FlWidgetWrapper<B> *>(w)->resize_cb =
                 [this](FlWidgetWrapper<B> *wid, int x, int y, int w, int h) {
@@ -31,14 +34,35 @@ struct GroupProps {
     void update(B *w, const GroupProps &other) {
         if (*this == other)
             return;
+        auto *wrapper = static_cast<FlWidgetWrapper<B> *>(w);
+        if (other.cached != cached) {
+            cached = other.cached;
+            wrapper->cached(cached);
+        }
         if (other.children != children) {
-            auto old_size = children.size();
-            auto new_size = other.children.size();
+            bool restructured = other.children.size() != children.size();
+            bool touched      = false;
+            auto old_size     = children.size();
+            auto new_size     = other.children.size();
             for (auto i = 0; i < std::min(old_size, new_size); i++) {
-                if (typeid(*children[i]) == typeid(*other.children[i]))
+                // The same node as last time, e.g. reused by a ChunkMemo
+                if (children[i] == other.children[i]) {
+                    frame_stats().reused_subtrees++;
+                    continue;
+                }
+                // A subtree built again with the same props
+                if (same_hash(*children[i], *other.children[i])) {
+                    frame_stats().skipped_subtrees++;
+                    continue;
+                }
+                touched = true;
+                if (patchable(children[i], other.children[i]))
                     children[i]->update(other.children[i].get());
                 else {
-                    children[i] = other.children[i];
+                    if (typeid(*children[i]) == typeid(*other.children[i]))
+                        frame_stats().remounted_subtrees++;
+                    restructured = true;
+                    children[i]  = other.children[i];
                     auto *c      = w->child(i);
                     w->remove(i);
                     delete c; // NOLINT
@@ -62,16 +86,50 @@ struct GroupProps {
                 }
                 children.resize(new_size);
             }
+            // Setters need not damage the widget they change, and damage is
+            // cleared once drawn, so any child not skipped spoils the copy
+            if (restructured || touched)
+                wrapper->invalidate_cache();
+            if (restructured)
+                wrapper->layout_dirty();
             Fl::redraw();
         }
     }
+    /// Update everything but the children
+    void update_shallow(B *w, const GroupProps &other) {
+        if (other.cached != cached) {
+            cached = other.cached;
+            static_cast<FlWidgetWrapper<B> *>(w)->cached(cached);
+        }
+    }
     bool operator==(const GroupProps &) const = default;
+    void hash(Hasher &h) const {
+        h(fill, cached);
+        for (const auto &c : children) {
+            auto hash = c->hash();
+            if (!hash)
+                h.unknown();
+            h(hash);
+        }
+    }
 };
 
 template <class Message, class W, class B>
 class GroupBase : public WidgetBase<Message, W, B> {
   protected:
     GroupProps<Message, B> gprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        gprops.hash(h);
+    }
+    /// Children are left out, as they are compared on their own
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               gprops.fill == other.gprops.fill &&
+               gprops.cached == other.gprops.cached;
+    }
+    /// Update props that subclasses add to the group
+    virtual void update_own(W *) {}
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -85,9 +143,29 @@ class GroupBase : public WidgetBase<Message, W, B> {
     }
     void update(Widget<Message> *other) override {
         auto f = (W *)other;
+        // The offscreen copy holds the group's own drawing too
+        if (!(this->wprops == f->wprops))
+            this->inner->invalidate_cache();
         WidgetBase<Message, W, B>::update(other);
-
         gprops.update(this->inner, f->gprops);
+        update_own(f);
+    }
+    void update_shallow(Widget<Message> *other) override {
+        auto f = (W *)other;
+        // A shallow patch means the group or something below it changed,
+        // and the patches below never reach this group's own update
+        this->inner->invalidate_cache();
+        WidgetBase<Message, W, B>::update(other);
+        gprops.update_shallow(this->inner, f->gprops);
+        update_own(f);
+    }
+    void refresh(Widget<Message> *other) override {
+        WidgetBase<Message, W, B>::refresh(other);
+        this->inner->invalidate_cache();
+    }
+    [[nodiscard]] std::span<const std::shared_ptr<Widget<Message>>>
+    child_nodes() const override {
+        return gprops.children;
     }
     virtual ~GroupBase() = default;
 
@@ -105,24 +183,38 @@ class GroupBase : public WidgetBase<Message, W, B> {
         gprops.fill = child;
         return *(W *)this;
     }
+    /// Draw the group from an offscreen copy, rendered again only after its
+    /// subtree changed or it was resized
+    W &cached(bool on = true) {
+        gprops.cached = on;
+        return *(W *)this;
+    }
 };
 
 template <class Message>
 class Flex : public GroupBase<Message, Flex<Message>, Fl_Flex> {
     std::tuple<int, int, int, int> margins_ = std::make_tuple(0, 0, 0, 0);
+    void hash_props(Hasher &h) const override {
+        GroupBase<Message, Flex<Message>, Fl_Flex>::hash_props(h);
+        h(margins_);
+    }
+    bool same_props(const Flex &other) const override {
+        return GroupBase<Message, Flex<Message>, Fl_Flex>::same_props(other) &&
+               margins_ == other.margins_;
+    }
     Fl_Widget *view() override {
         GroupBase<Message, Flex<Message>, Fl_Flex>::view();
         auto [l, t, r, b] = margins_;
         this->inner->margin(l, t, r, b);
         return this->inner;
     }
-    void update(Widget<Message> *other) override {
-        GroupBase<Message, Flex<Message>, Fl_Flex>::update(other);
-        auto f = (Flex *)other;
+    void update_own(Flex *f) override {
         if (margins_ != f->margins_) {
             margins_          = f->margins_;
             auto [l, t, r, b] = margins_;
             this->inner->margin(l, t, r, b);
+            this->inner->layout_dirty();
+            this->inner->invalidate_cache();
         }
     }
 
@@ -152,17 +244,24 @@ class Flex : public GroupBase<Message, Flex<Message>, Fl_Flex> {
 template <class Message>
 class Pack : public GroupBase<Message, Pack<Message>, Fl_Pack> {
     int spacing_ = 0;
+    void hash_props(Hasher &h) const override {
+        GroupBase<Message, Pack<Message>, Fl_Pack>::hash_props(h);
+        h(spacing_);
+    }
+    bool same_props(const Pack &other) const override {
+        return GroupBase<Message, Pack<Message>, Fl_Pack>::same_props(other) &&
+               spacing_ == other.spacing_;
+    }
     Fl_Widget *view() override {
         GroupBase<Message, Pack<Message>, Fl_Pack>::view();
         this->inner->spacing(spacing_);
         return this->inner;
     }
-    void update(Widget<Message> *other) override {
-        GroupBase<Message, Pack<Message>, Fl_Pack>::update(other);
-        auto f = (Pack *)other;
+    void update_own(Pack *f) override {
         if (spacing_ != f->spacing_) {
             spacing_ = f->spacing_;
             this->inner->spacing(spacing_);
+            this->inner->invalidate_cache();
         }
     }
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "function.hpp"
+#include "widget.hpp"
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+
+/// What a widget sends when it is triggered: a message value, or a closure
+/// producing one. Handlers compare by a stable identity, so that diffing
+/// can tell whether a widget's handler really changed.
+template <class Message>
+class Handler {
+    std::optional<Message> value_;
+    detail::InlineFunction<Message()> fn_;
+    std::optional<std::uint64_t> key_;
+
+  public:
+    Handler() = default;
+    /// Send msg. Equal to handlers sending an equal message.
+    Handler(Message msg) : value_(std::move(msg)) {}
+    /// Send what f returns when triggered. Never equal to another handler,
+    /// so it is rebound on every update.
+    template <class F>
+        requires(!std::is_convertible_v<F, Message> &&
+                 std::is_invocable_r_v<Message, std::decay_t<F> &>)
+    Handler(F &&f) : fn_(std::forward<F>(f)) {}
+    /// Send what f returns when triggered. Equal to handlers with the same
+    /// key, so f is only rebound when the key changes.
+    template <class F>
+        requires(std::is_invocable_r_v<Message, std::decay_t<F> &>)
+    Handler(std::uint64_t key, F &&f) : fn_(std::forward<F>(f)), key_(key) {}
+
+    explicit operator bool() const { return value_ || fn_; }
+    Message operator()() const { return value_ ? *value_ : fn_(); }
+    bool operator==(const Handler &other) const {
+        if (this == &other || (!*this && !other))
+            return true;
+        if (key_ || other.key_)
+            return key_ == other.key_;
+        if constexpr (std::equality_comparable<Message>) {
+            if (value_ && other.value_)
+                return *value_ == *other.value_;
+        }
+        return false;
+    }
+    /// Unknown for closures without a key, and for messages the hasher
+    /// cannot handle
+    void hash(detail::Hasher &h) const {
+        if (!*this) {
+            h(0);
+        } else if (key_) {
+            h(1, *key_);
+        } else if (value_) {
+            if constexpr (std::is_arithmetic_v<Message> ||
+                          std::is_enum_v<Message> ||
+                          requires { value_->hash(h); })
+                h(2, *value_);
+            else
+                h.unknown();
+        } else {
+            h.unknown();
+        }
+    }
+};
+} // namespace rf
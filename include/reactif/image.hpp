@@ -0,0 +1,323 @@
+#pragma once
+
+#include "pool.hpp"
+#include "widget.hpp"
+#include <FL/Enumerations.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_JPEG_Image.H>
+#include <FL/Fl_PNG_Image.H>
+#include <FL/Fl_RGB_Image.H>
+#include <FL/fl_draw.H>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rf::detail {
+
+class ImageDisplay;
+
+/// Decoded images shared by every image() showing the same source.
+/// Decoding and scaling run on the thread pool; results are delivered on the
+/// UI thread through Fl::awake. Entries are evicted least recently used once
+/// the byte budget is exceeded, while widgets still showing an evicted image
+/// keep it alive.
+class ImageCache {
+  public:
+    struct Key {
+        std::string path;
+        int w = 0;
+        int h = 0;
+        bool operator==(const Key &) const = default;
+    };
+    using Image = std::shared_ptr<Fl_RGB_Image>;
+
+  private:
+    struct KeyHash {
+        std::size_t operator()(const Key &k) const {
+            auto h = std::hash<std::string>()(k.path);
+            return h ^ (std::hash<int>()(k.w) * 31 + std::hash<int>()(k.h));
+        }
+    };
+    struct Entry {
+        Image image;
+        std::size_t bytes = 0;
+        std::list<Key>::iterator lru;
+    };
+    struct Pending {
+        std::vector<ImageDisplay *> waiters;
+        std::shared_ptr<std::atomic<bool>> wanted;
+    };
+    /// A finished request. A skipped one was never decoded, as opposed to
+    /// one whose source failed to decode.
+    struct Result {
+        Key key;
+        Image image;
+        bool skipped = false;
+    };
+    /// Decoded images handed from workers to the UI thread
+    struct Results {
+        std::mutex mtx;
+        std::vector<Result> ready;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+    std::list<Key> lru_;
+    std::unordered_map<Key, Pending, KeyHash> pending_;
+    std::shared_ptr<Results> results_ = std::make_shared<Results>();
+    std::size_t bytes_                = 0;
+    std::size_t budget_               = std::size_t(256) << 20;
+
+    static Image decode(const Key &key) {
+        auto ext = key.path.substr(key.path.rfind('.') + 1);
+        for (auto &c : ext)
+            c = (char)std::tolower((unsigned char)c);
+        std::unique_ptr<Fl_RGB_Image> img;
+        if (ext == "png")
+            img = std::make_unique<Fl_PNG_Image>(key.path.c_str());
+        else if (ext == "jpg" || ext == "jpeg")
+            img = std::make_unique<Fl_JPEG_Image>(key.path.c_str());
+        if (!img || img->fail())
+            return nullptr;
+        if ((key.w > 0 && key.w != img->w()) ||
+            (key.h > 0 && key.h != img->h())) {
+            // Scale to fit the requested box, keeping the aspect ratio
+            auto sw = key.w > 0 ? (double)key.w / img->w() : 1e9;
+            auto sh = key.h > 0 ? (double)key.h / img->h() : 1e9;
+            auto s  = std::min(sw, sh);
+            auto w  = std::max(1, (int)(img->w() * s));
+            auto h  = std::max(1, (int)(img->h() * s));
+            img.reset(static_cast<Fl_RGB_Image *>(img->copy(w, h)));
+        }
+        return Image(std::move(img));
+    }
+    static void awake_cb(void *) { global().deliver(); }
+    void deliver();
+    void insert(const Key &key, const Image &image) {
+        auto bytes = (std::size_t)image->w() * image->h() * image->d();
+        lru_.push_front(key);
+        entries_[key] = Entry{image, bytes, lru_.begin()};
+        bytes_ += bytes;
+        evict();
+    }
+    void evict() {
+        while (bytes_ > budget_ && lru_.size() > 1) {
+            auto it = entries_.find(lru_.back());
+            bytes_ -= it->second.bytes;
+            entries_.erase(it);
+            lru_.pop_back();
+        }
+    }
+
+  public:
+    /// The cache shared by all image widgets
+    static ImageCache &global() {
+        static ImageCache cache;
+        return cache;
+    }
+    /// Set the number of decoded bytes kept
+    void budget(std::size_t bytes) {
+        budget_ = bytes;
+        evict();
+    }
+    [[nodiscard]] std::size_t bytes() const { return bytes_; }
+    /// Get a decoded image, marking it recently used
+    Image find(const Key &key) {
+        auto it = entries_.find(key);
+        if (it == entries_.end())
+            return nullptr;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return it->second.image;
+    }
+    /// Decode key in the background and notify w when done. Requests for a
+    /// source that is already being decoded join the one in flight.
+    void request(const Key &key, ImageDisplay *w) {
+        auto &p = pending_[key];
+        p.waiters.push_back(w);
+        if (p.wanted) {
+            *p.wanted = true;
+            return;
+        }
+        p.wanted = std::make_shared<std::atomic<bool>>(true);
+        ThreadPool::global().submit(
+            [key, wanted = p.wanted, results = results_] {
+                // Skip sources nobody is waiting for any more
+                Result r{key, nullptr, !*wanted};
+                if (!r.skipped)
+                    r.image = decode(key);
+                {
+                    std::lock_guard<std::mutex> lock(results->mtx);
+                    results->ready.push_back(std::move(r));
+                }
+                Fl::awake(awake_cb, nullptr);
+            }
+        );
+    }
+    /// Stop notifying w
+    void cancel(const Key &key, ImageDisplay *w) {
+        auto it = pending_.find(key);
+        if (it == pending_.end())
+            return;
+        auto &waiters = it->second.waiters;
+        waiters.erase(
+            std::remove(waiters.begin(), waiters.end(), w), waiters.end()
+        );
+        if (waiters.empty())
+            *it->second.wanted = false;
+    }
+};
+
+/// Shows an image decoded in the background, with a placeholder frame until
+/// it is ready
+class ImageDisplay : public Fl_Box {
+    ImageCache::Key key_;
+    ImageCache::Image image_;
+    bool waiting_ = false;
+
+  protected:
+    void draw() override {
+        draw_box();
+        auto X = x() + Fl::box_dx(box());
+        auto Y = y() + Fl::box_dy(box());
+        auto W = w() - Fl::box_dw(box());
+        auto H = h() - Fl::box_dh(box());
+        if (image_) {
+            fl_push_clip(X, Y, W, H);
+            image_->draw(
+                X + (W - image_->w()) / 2,
+                Y + (H - image_->h()) / 2
+            );
+            fl_pop_clip();
+        } else if (waiting_) {
+            fl_color(FL_INACTIVE_COLOR);
+            fl_rect(X + 2, Y + 2, W - 4, H - 4);
+        }
+        draw_label();
+    }
+
+  public:
+    ImageDisplay(int x, int y, int w, int h, const char *label = nullptr)
+        : Fl_Box(x, y, w, h, label) {}
+    ImageDisplay(const ImageDisplay &)            = delete;
+    ImageDisplay &operator=(const ImageDisplay &) = delete;
+    ~ImageDisplay() override {
+        if (waiting_)
+            ImageCache::global().cancel(key_, this);
+    }
+    /// Show path decoded to fit w x h, or at its own size if they are 0
+    void source(const std::string &path, int w = 0, int h = 0) {
+        auto &cache = ImageCache::global();
+        if (waiting_)
+            cache.cancel(key_, this);
+        key_     = ImageCache::Key{path, w, h};
+        image_   = path.empty() ? nullptr : cache.find(key_);
+        waiting_ = !path.empty() && !image_;
+        if (waiting_)
+            cache.request(key_, this);
+        redraw();
+    }
+    /// Called by the cache once a requested image is decoded
+    void ready(const ImageCache::Key &key, ImageCache::Image image) {
+        if (!waiting_ || !(key == key_))
+            return;
+        waiting_ = false;
+        image_   = std::move(image);
+        redraw();
+    }
+    [[nodiscard]] bool loading() const { return waiting_; }
+};
+
+inline void ImageCache::deliver() {
+    std::vector<Result> ready;
+    {
+        std::lock_guard<std::mutex> lock(results_->mtx);
+        ready.swap(results_->ready);
+    }
+    for (auto &[key, image, skipped] : ready) {
+        auto it = pending_.find(key);
+        if (it == pending_.end())
+            continue;
+        auto waiters = std::move(it->second.waiters);
+        pending_.erase(it);
+        if (skipped) {
+            // Requested again after the worker saw it unwanted
+            for (auto *w : waiters)
+                request(key, w);
+            continue;
+        }
+        if (image)
+            insert(key, image);
+        for (auto *w : waiters)
+            w->ready(key, image);
+    }
+}
+
+template <class B>
+struct ImageProps {
+    std::optional<std::string> path;
+    std::pair<int, int> fit = {0, 0};
+    void view(B *w) {
+        if (path)
+            w->source(*path, fit.first, fit.second);
+    }
+    void update(B *w, const ImageProps &other) {
+        if (*this == other)
+            return;
+        path = other.path;
+        fit  = other.fit;
+        w->source(path ? *path : std::string(), fit.first, fit.second);
+    }
+    bool operator==(const ImageProps &) const = default;
+    void hash(Hasher &h) const { h(path, fit); }
+};
+
+template <class Message, class W, class B>
+class ImageBase : public WidgetBase<Message, W, B> {
+  protected:
+    ImageProps<B> iprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        iprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               iprops == other.iprops;
+    }
+
+  public:
+    std::shared_ptr<Widget<Message>> create() override {
+        return std::shared_ptr<Widget<Message>>(new W(*(W *)this));
+    }
+    Fl_Widget *view() override {
+        WidgetBase<Message, W, B>::view();
+        this->iprops.view(this->inner);
+        return this->inner;
+    }
+    void update(Widget<Message> *other) override {
+        auto f = (W *)other;
+        WidgetBase<Message, W, B>::update(other);
+        this->iprops.update(this->inner, f->iprops);
+    }
+    virtual ~ImageBase() = default;
+
+    /// Set the image file, decoded to fit w x h if they are not 0
+    W &source(std::string_view path, int w = 0, int h = 0) {
+        iprops.path = std::string(path);
+        iprops.fit  = {w, h};
+        return *(W *)this;
+    }
+};
+
+#define IMAGE(Class, Base)                                                     \
+    template <class Message>                                                   \
+    class Class : public ImageBase<Message, Class<Message>, Base> {};
+
+IMAGE(Image, ImageDisplay)
+} // namespace rf::detail
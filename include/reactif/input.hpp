@@ -1,6 +1,7 @@
 #pragma once
 
 #include "enums.hpp"
+#include "handler.hpp"
 #include "widget.hpp"
 #include <FL/Enumerations.H>
 #include <FL/Fl_File_Input.H>
@@ -9,19 +10,103 @@
 #include <FL/Fl_Int_Input.H>
 #include <FL/Fl_Multiline_Input.H>
 #include <FL/Fl_Secret_Input.H>
+#include <cstdint>
+#include <string_view>
+
+namespace rf {
+
+/// A lazily-read binding to an input's text.
+/// The FLTK buffer is the source of truth: typing only bumps version(), and
+/// the text is read from the widget when view() or str() is called. Until a
+/// widget is bound the last text set is returned, and after it is deleted
+/// the text it held.
+class InputValue {
+    Fl_Widget *widget_ = nullptr;
+    std::string text_;
+    std::uint64_t version_ = 0;
+
+    /// The widget's delete hook, if it is a reactif widget
+    detail::DeleteHook *hook() const {
+        return dynamic_cast<detail::DeleteHook *>(widget_);
+    }
+    /// Keep the widget's text and stop reading from it
+    void unbind() {
+        text_ = view();
+        release();
+    }
+    void release() {
+        auto *h = hook();
+        if (h && h->on_delete_data == this)
+            *h = {};
+        Fl::release_widget_pointer(widget_);
+        widget_ = nullptr;
+    }
+
+  public:
+    InputValue() = default;
+    explicit InputValue(std::string_view text) : text_(text) {}
+    InputValue(const InputValue &)            = delete;
+    InputValue &operator=(const InputValue &) = delete;
+    ~InputValue() {
+        if (widget_)
+            release();
+    }
+    /// Get the current text without copying it
+    [[nodiscard]] std::string_view view() const {
+        if (widget_) {
+            auto *i = static_cast<Fl_Input_ *>(widget_);
+            return {i->value(), (std::size_t)i->size()};
+        }
+        return text_;
+    }
+    /// Get a copy of the current text
+    [[nodiscard]] std::string str() const { return std::string(view()); }
+    [[nodiscard]] bool empty() const { return view().empty(); }
+    /// Incremented on every edit, for cheap change detection
+    [[nodiscard]] std::uint64_t version() const { return version_; }
+    /// Replace the text
+    void set(std::string_view text) {
+        if (widget_)
+            static_cast<Fl_Input_ *>(widget_)->value(text.data(), text.size());
+        else
+            text_ = text;
+        version_++;
+    }
+    /// Attach the binding to an input widget. The text is read back from a
+    /// reactif widget when it is deleted; other widgets only detach.
+    void bind(Fl_Input_ *w) {
+        if (widget_ == w)
+            return;
+        if (widget_)
+            unbind();
+        widget_ = w;
+        Fl::watch_widget_pointer(widget_);
+        w->value(text_.data(), text_.size());
+        if (auto *h = hook())
+            *h = {[](void *self) { ((InputValue *)self)->unbind(); }, this};
+    }
+    /// Record an edit made through the widget
+    void touch() { version_++; }
+};
+} // namespace rf
 
 namespace rf::detail {
 
 template <class Message, class B>
 struct InputProps {
     std::optional<std::shared_ptr<std::string>> value;
+    std::optional<std::shared_ptr<InputValue>> binding;
     std::optional<Color> textcolor;
     std::optional<Font> textfont;
     std::optional<int> textsize;
-    std::optional<std::shared_ptr<std::function<Message()>>> on_trigger;
+    Handler<Message> on_trigger;
+    Handler<Message> on_change;
+    std::optional<int> debounce;
     void view(B *w) {
         if (value)
             w->value((*value)->c_str());
+        if (binding)
+            (*binding)->bind(w);
         if (textcolor)
             w->textcolor(*textcolor);
         if (textfont)
@@ -37,6 +122,11 @@ struct InputProps {
             if (value)
                 w->value((*value)->c_str());
         }
+        if (other.binding != binding) {
+            binding = other.binding;
+            if (binding)
+                (*binding)->bind(w);
+        }
         if (other.textcolor != textcolor) {
             textcolor = other.textcolor;
             if (textcolor)
@@ -52,14 +142,75 @@ struct InputProps {
             if (textsize)
                 w->textcolor(*textsize);
         }
+        // The callback reads these at call time, so assigning rebinds it
+        if (other.on_trigger != on_trigger)
+            on_trigger = other.on_trigger;
+        if (other.on_change != on_change)
+            on_change = other.on_change;
+        if (other.debounce != debounce)
+            debounce = other.debounce;
     }
     bool operator==(const InputProps &) const = default;
+    void hash(Hasher &h) const {
+        h(value, binding, textcolor, textfont, textsize);
+        h(on_trigger, on_change, debounce);
+    }
 };
 
 template <class Message, class W, class B>
 class InputBase : public WidgetBase<Message, W, B> {
+    bool listening_ = false;
+    /// Install the callback once a prop needs it, which may first happen
+    /// on an update, and add the triggers it relies on to those set with
+    /// when()
+    void listen() {
+        auto &p = this->iprops;
+        if (!p.value && !p.binding && !p.on_change && !p.on_trigger)
+            return;
+        int when = FL_WHEN_CHANGED;
+        if (p.on_trigger)
+            when |= FL_WHEN_ENTER_KEY_ALWAYS;
+        if (this->wprops.when)
+            when |= *this->wprops.when;
+        if (this->inner->when() != when)
+            this->inner->when(when);
+        if (listening_)
+            return;
+        listening_ = true;
+        // Reads the node's props at call time, so no per-keystroke state is
+        // captured and a reconciled binding is picked up
+        static_cast<FlWidgetWrapper<B> *>(this->inner)->cb([this](auto *w) {
+            auto &props = this->iprops;
+            if (Fl::callback_reason() == FL_REASON_CHANGED) {
+                if (props.value)
+                    (*props.value)->assign(w->value(), w->size());
+                if (props.binding)
+                    (*props.binding)->touch();
+                if (props.on_change && props.debounce && *props.debounce > 0)
+                    w->debounce(*props.debounce / 1000.0, [this] {
+                        if (this->iprops.on_change)
+                            Fl::awake((void *)&this->iprops.on_change);
+                    });
+                else if (props.on_change)
+                    Fl::awake((void *)&props.on_change);
+            }
+            if (props.on_trigger &&
+                Fl::callback_reason() == FL_REASON_ENTER_KEY) {
+                Fl::awake((void *)&props.on_trigger);
+            }
+        });
+    }
+
   protected:
     InputProps<Message, B> iprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        iprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               iprops == other.iprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -68,33 +219,14 @@ class InputBase : public WidgetBase<Message, W, B> {
     Fl_Widget *view() override {
         WidgetBase<Message, W, B>::view();
         this->iprops.view(this->inner);
-        if (this->iprops.value) {
-            int when = FL_WHEN_CHANGED;
-            if (this->iprops.on_trigger)
-                when |= FL_WHEN_ENTER_KEY_ALWAYS;
-            this->inner->when(when);
-            static_cast<FlWidgetWrapper<B> *>(this->inner)
-                ->cb([data = this->iprops.value->get(),
-                      cb   = this->iprops.on_trigger
-                                 ? this->iprops.on_trigger->get()
-                                 : nullptr](auto *w) {
-                    if (data && Fl::callback_reason() == FL_REASON_CHANGED) {
-                        auto i     = static_cast<B *>(w);
-                        auto val   = i->value();
-                        auto data1 = static_cast<std::string *>(data);
-                        *data1     = std::string(val);
-                    }
-                    if (cb && Fl::callback_reason() == FL_REASON_ENTER_KEY) {
-                        Fl::awake(cb);
-                    }
-                });
-        }
+        listen();
         return this->inner;
     }
     void update(Widget<Message> *other) override {
         WidgetBase<Message, W, B>::update(other);
         auto f = (W *)other;
         this->iprops.update(this->inner, f->iprops);
+        listen();
     }
     virtual ~InputBase() = default;
 
@@ -103,6 +235,11 @@ class InputBase : public WidgetBase<Message, W, B> {
         iprops.value = value;
         return *(W *)this;
     }
+    /// Bind the input to a lazily-read value, see InputValue
+    W &value(std::shared_ptr<InputValue> value) {
+        iprops.binding = value;
+        return *(W *)this;
+    }
     /// Set the input's textcolor
     W &textcolor(Color col) {
         iprops.textcolor = col;
@@ -119,9 +256,18 @@ class InputBase : public WidgetBase<Message, W, B> {
         return *(W *)this;
     }
     /// Set the input's callback message
-    W &on_trigger(std::function<Message()> &&msg) {
-        iprops.on_trigger =
-            std::make_shared<std::function<Message()>>(std::move(msg));
+    W &on_trigger(Handler<Message> msg) {
+        iprops.on_trigger = std::move(msg);
+        return *(W *)this;
+    }
+    /// Set the message sent when the text changes
+    W &on_change(Handler<Message> msg) {
+        iprops.on_change = std::move(msg);
+        return *(W *)this;
+    }
+    /// Only send the change message once typing pauses for ms milliseconds
+    W &debounce(int ms) {
+        iprops.debounce = ms;
         return *(W *)this;
     }
 };
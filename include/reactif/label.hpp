@@ -0,0 +1,137 @@
+#pragma once
+
+#include <FL/Fl_Widget.H>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace rf {
+
+/// A string stored once in a process-wide pool. Equal strings intern to the
+/// same pointer, so two interned strings compare by pointer, and the text
+/// outlives every widget so FLTK can use it without copying.
+class Interned {
+    const char *ptr_;
+    explicit Interned(const char *ptr) : ptr_(ptr) {}
+    friend Interned intern(std::string_view s);
+
+  public:
+    /// Get the interned text
+    [[nodiscard]] const char *c_str() const { return ptr_; }
+    bool operator==(const Interned &other) const { return ptr_ == other.ptr_; }
+};
+
+/// Intern a string, returning the pooled copy
+inline Interned intern(std::string_view s) {
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view v) const {
+            return std::hash<std::string_view>{}(v);
+        }
+    };
+    static std::mutex mtx;
+    static std::unordered_set<std::string, Hash, std::equal_to<>> pool;
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = pool.find(s);
+    if (it == pool.end())
+        it = pool.emplace(s).first;
+    return Interned(it->c_str());
+}
+
+/// A string literal, or other constant array with static storage, which
+/// FLTK can use without copying. The constructor is explicit and consteval,
+/// so only constant arrays are accepted and only when asked for by name, as
+/// in label(Literal("OK")); plain strings and buffers are copied.
+class Literal {
+    const char *ptr_;
+
+  public:
+    template <std::size_t N>
+    explicit consteval Literal(const char (&s)[N]) : ptr_(s) {}
+    /// Get the literal text
+    [[nodiscard]] constexpr const char *c_str() const { return ptr_; }
+};
+
+namespace detail {
+
+/// Label storage used by the widget props.
+/// Literals and interned strings are kept as pointers and handed to FLTK
+/// without a copy. Short dynamic strings are stored inline in the node, which
+/// owns its FLTK widget, so FLTK borrows those too. Only long strings use the
+/// heap and FLTK's copy_label.
+class Label {
+  public:
+    static constexpr std::size_t inline_size = 32;
+
+  private:
+    enum class Kind : uint8_t { Static, Interned, Inline, Owned };
+    Kind kind_                            = Kind::Inline;
+    const char *ptr_                      = nullptr;
+    std::array<char, inline_size> inline_ = {};
+    std::string owned_;
+
+  public:
+    Label() = default;
+    Label(std::string_view s) {
+        if (s.size() < inline_size) {
+            std::memcpy(inline_.data(), s.data(), s.size());
+            inline_[s.size()] = '\0';
+        } else {
+            kind_  = Kind::Owned;
+            owned_ = s;
+        }
+    }
+    Label(Interned s) : kind_(Kind::Interned), ptr_(s.c_str()) {}
+    Label(Literal s) : kind_(Kind::Static), ptr_(s.c_str()) {}
+    /// Format into the inline buffer, spilling to the heap only if needed
+    template <class... Args>
+    static Label format(const char *fmt, Args... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            return Label(std::string_view(fmt));
+        } else {
+            Label l;
+            auto n = std::snprintf(l.inline_.data(), inline_size, fmt, args...);
+            if (n >= (int)inline_size) {
+                l.kind_ = Kind::Owned;
+                l.owned_.resize(n);
+                std::snprintf(l.owned_.data(), n + 1, fmt, args...);
+            }
+            return l;
+        }
+    }
+    [[nodiscard]] const char *c_str() const {
+        switch (kind_) {
+        case Kind::Static:
+        case Kind::Interned:
+            return ptr_;
+        case Kind::Inline:
+            return inline_.data();
+        default:
+            return owned_.c_str();
+        }
+    }
+    /// Set the label on an FLTK widget, copying only heap-stored text
+    void apply(Fl_Widget *w) const {
+        if (kind_ == Kind::Owned)
+            w->copy_label(owned_.c_str());
+        else
+            w->label(c_str());
+    }
+    bool operator==(const Label &other) const {
+        auto *a = c_str();
+        auto *b = other.c_str();
+        if (a == b)
+            return true;
+        if (kind_ == Kind::Interned && other.kind_ == Kind::Interned)
+            return false;
+        return std::strcmp(a, b) == 0;
+    }
+};
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "text.hpp"
+#include "widget.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rf {
+
+/// A bounded, thread-safe buffer of log lines.
+/// Any thread may append; once capacity lines are held the oldest are
+/// dropped. Line slots are reused, so steady-state appends do not allocate,
+/// and the lock is held once per chunk rather than per line.
+class LogBuffer {
+    mutable std::mutex mtx_;
+    std::vector<std::string> lines_;
+    std::size_t head_  = 0;
+    std::size_t count_ = 0;
+    std::string partial_;
+    std::uint64_t dropped_              = 0;
+    std::atomic<std::uint64_t> version_ = 0;
+
+    void push(std::string_view a, std::string_view b) {
+        std::string *slot = nullptr;
+        if (count_ < lines_.size()) {
+            slot = &lines_[(head_ + count_) % lines_.size()];
+            count_++;
+        } else {
+            slot  = &lines_[head_];
+            head_ = (head_ + 1) % lines_.size();
+            dropped_++;
+        }
+        slot->assign(a);
+        slot->append(b);
+    }
+
+  public:
+    explicit LogBuffer(std::size_t capacity = 10000) // NOLINT
+        : lines_(std::max<std::size_t>(capacity, 1)) {}
+    /// Append text; it is split on newlines, and a trailing partial line is
+    /// completed by later appends
+    void append(std::string_view chunk) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        while (!chunk.empty()) {
+            const auto *nl =
+                (const char *)std::memchr(chunk.data(), '\n', chunk.size());
+            if (!nl) {
+                partial_.append(chunk);
+                break;
+            }
+            auto len = (std::size_t)(nl - chunk.data());
+            push(partial_, chunk.substr(0, len));
+            partial_.clear();
+            chunk.remove_prefix(len + 1);
+        }
+        version_.fetch_add(1, std::memory_order_release);
+    }
+    /// Remove all lines
+    void clear() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        dropped_ += count_;
+        head_  = 0;
+        count_ = 0;
+        partial_.clear();
+        version_.fetch_add(1, std::memory_order_release);
+    }
+    [[nodiscard]] std::size_t capacity() const { return lines_.size(); }
+    /// Number of lines held, including an unterminated last line
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return count_ + (partial_.empty() ? 0 : 1);
+    }
+    /// Total number of lines dropped from the front so far
+    [[nodiscard]] std::uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return dropped_;
+    }
+    /// Incremented on every change, readable without locking
+    [[nodiscard]] std::uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
+    }
+    /// Call f(i, text) for each line in [first, first + n) under the lock
+    template <class F>
+    void visit(std::size_t first, std::size_t n, F &&f) const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto total = count_ + (partial_.empty() ? 0 : 1);
+        for (auto i = first; i < std::min(first + n, total); i++) {
+            if (i < count_)
+                f(i, std::string_view(lines_[(head_ + i) % lines_.size()]));
+            else
+                f(i, std::string_view(partial_));
+        }
+    }
+};
+
+namespace detail {
+
+/// Displays a LogBuffer, redrawing at most once per frame.
+/// The view follows new output while scrolled to the bottom, and otherwise
+/// keeps its lines in place as old ones are dropped.
+class LogDisplay : public LineDisplay {
+    std::shared_ptr<LogBuffer> buffer_;
+    std::uint64_t version_ = 0;
+    std::uint64_t dropped_ = 0;
+    std::size_t count_     = 0;
+
+    static constexpr double frame = 1.0 / 60;
+
+    static void frame_cb(void *data) {
+        auto *self = static_cast<LogDisplay *>(data);
+        self->refresh();
+        Fl::repeat_timeout(frame, frame_cb, data);
+    }
+
+  protected:
+    [[nodiscard]] std::size_t line_count() const override { return count_; }
+    void visit_lines(
+        std::size_t first, std::size_t n, const Visitor &f
+    ) override {
+        if (buffer_)
+            buffer_->visit(first, n, f);
+    }
+
+  public:
+    LogDisplay(int x, int y, int w, int h, const char *label = nullptr)
+        : LineDisplay(x, y, w, h, label) {
+        Fl::add_timeout(frame, frame_cb, this);
+    }
+    LogDisplay(const LogDisplay &)            = delete;
+    LogDisplay &operator=(const LogDisplay &) = delete;
+    ~LogDisplay() override { Fl::remove_timeout(frame_cb, this); }
+    /// Display another buffer
+    void buffer(std::shared_ptr<LogBuffer> buffer) {
+        buffer_  = std::move(buffer);
+        version_ = 0;
+        dropped_ = buffer_ ? buffer_->dropped() : 0;
+        count_   = 0;
+        refresh();
+        scroll_to_bottom();
+    }
+    /// Pick up appended lines, called once per frame
+    void refresh() {
+        if (!buffer_) {
+            if (count_) {
+                count_ = 0;
+                lines_changed();
+            }
+            return;
+        }
+        auto version = buffer_->version();
+        if (version == version_)
+            return;
+        version_     = version;
+        bool pinned  = at_bottom();
+        auto dropped = buffer_->dropped();
+        auto shift   = (std::size_t)(dropped - dropped_);
+        auto top     = top_line();
+        dropped_     = dropped;
+        count_       = buffer_->size();
+        if (pinned)
+            scroll_to_bottom();
+        else
+            top_line(top > shift ? top - shift : 0);
+        lines_changed();
+    }
+};
+
+template <class B>
+struct LogViewProps {
+    std::optional<std::shared_ptr<LogBuffer>> buffer;
+    std::optional<Color> textcolor;
+    std::optional<Font> textfont;
+    std::optional<int> textsize;
+    void view(B *w) {
+        if (textcolor)
+            w->textcolor(*textcolor);
+        if (textfont)
+            w->textfont(*textfont);
+        if (textsize)
+            w->textsize(*textsize);
+        if (buffer)
+            w->buffer(*buffer);
+    }
+    void update(B *w, const LogViewProps &other) {
+        if (*this == other)
+            return;
+        if (other.buffer != buffer) {
+            buffer = other.buffer;
+            w->buffer(buffer ? *buffer : nullptr);
+        }
+        if (other.textcolor != textcolor) {
+            textcolor = other.textcolor;
+            if (textcolor)
+                w->textcolor(*textcolor);
+        }
+        if (other.textfont != textfont) {
+            textfont = other.textfont;
+            if (textfont)
+                w->textfont(*textfont);
+        }
+        if (other.textsize != textsize) {
+            textsize = other.textsize;
+            if (textsize)
+                w->textsize(*textsize);
+        }
+    }
+    bool operator==(const LogViewProps &) const = default;
+    void hash(Hasher &h) const { h(buffer, textcolor, textfont, textsize); }
+};
+
+template <class Message, class W, class B>
+class LogViewBase : public WidgetBase<Message, W, B> {
+  protected:
+    LogViewProps<B> lprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        lprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               lprops == other.lprops;
+    }
+
+  public:
+    std::shared_ptr<Widget<Message>> create() override {
+        return std::shared_ptr<Widget<Message>>(new W(*(W *)this));
+    }
+    Fl_Widget *view() override {
+        WidgetBase<Message, W, B>::view();
+        this->lprops.view(this->inner);
+        return this->inner;
+    }
+    void update(Widget<Message> *other) override {
+        auto f = (W *)other;
+        WidgetBase<Message, W, B>::update(other);
+        this->lprops.update(this->inner, f->lprops);
+    }
+    virtual ~LogViewBase() = default;
+
+    /// Set the buffer to display
+    W &buffer(std::shared_ptr<LogBuffer> buffer) {
+        lprops.buffer = std::move(buffer);
+        return *(W *)this;
+    }
+    /// Set the text color
+    W &textcolor(Color col) {
+        lprops.textcolor = col;
+        return *(W *)this;
+    }
+    /// Set the text size
+    W &textsize(int sz) {
+        lprops.textsize = sz;
+        return *(W *)this;
+    }
+    /// Set the text font
+    W &textfont(Font font) {
+        lprops.textfont = font;
+        return *(W *)this;
+    }
+};
+
+#define LOGVIEW(Class, Base)                                                   \
+    template <class Message>                                                   \
+    class Class : public LogViewBase<Message, Class<Message>, Base> {};
+
+LOGVIEW(LogView, LogDisplay)
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rf::detail {
+
+/// A read-only memory mapping of a whole file.
+/// Pages are only faulted in when touched, so opening is O(1) in file size.
+class MappedFile {
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool valid_       = false;
+#ifdef _WIN32
+    HANDLE file_    = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+
+  public:
+    explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+        file_ = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (file_ == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file_, &sz))
+            return;
+        size_  = (std::size_t)sz.QuadPart;
+        valid_ = true;
+        if (size_ == 0)
+            return;
+        mapping_ =
+            CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_)
+            data_ = (const char *)
+                MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        valid_ = data_ != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY); // NOLINT
+        if (fd < 0)
+            return;
+        struct stat st = {};
+        if (::fstat(fd, &st) == 0) {
+            size_  = (std::size_t)st.st_size;
+            valid_ = true;
+            if (size_ > 0) {
+                auto *p =
+                    ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) // NOLINT
+                    valid_ = false;
+                else
+                    data_ = (const char *)p;
+            }
+        }
+        ::close(fd);
+#endif
+        if (!valid_)
+            size_ = 0;
+    }
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_)
+            UnmapViewOfFile(data_);
+        if (mapping_)
+            CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+#else
+        if (data_)
+            ::munmap((void *)data_, size_); // NOLINT
+#endif
+    }
+    [[nodiscard]] bool valid() const { return valid_; }
+    [[nodiscard]] const char *data() const { return data_; }
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] std::string_view view() const { return {data_, size_}; }
+};
+
+/// Line start offsets of a mapped file, built incrementally on a background
+/// thread. Only every stride-th line start is stored; the lines in between
+/// are found with memchr, which keeps the index small for text viewing while
+/// a stride of 1 gives direct access for row-oriented data.
+class LineIndex {
+    std::shared_ptr<const MappedFile> file_;
+    std::size_t stride_;
+    mutable std::mutex mtx_;
+    std::vector<std::uint64_t> starts_ = {0};
+    std::atomic<std::size_t> lines_    = 0;
+    std::atomic<bool> done_            = false;
+    std::jthread worker_;
+
+    static constexpr std::size_t chunk = 4 << 20;
+
+    void run(const std::stop_token &st) {
+        const auto *data = file_->data();
+        auto size        = file_->size();
+        std::vector<std::uint64_t> batch;
+        std::size_t count = 0;
+        std::size_t pos   = 0;
+        while (pos < size && !st.stop_requested()) {
+            auto end      = std::min(pos + chunk, size);
+            const char *p = data + pos;
+            while ((p = (const char *)std::memchr(p, '\n', data + end - p))) {
+                p++;
+                count++;
+                if (count % stride_ == 0 && p < data + size)
+                    batch.push_back(p - data);
+            }
+            pos = end;
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                starts_.insert(starts_.end(), batch.begin(), batch.end());
+            }
+            batch.clear();
+            lines_ = count;
+        }
+        if (size > 0 && data[size - 1] != '\n')
+            count++;
+        lines_ = count;
+        done_  = true;
+    }
+
+    /// Offset just past the newline that ends the line starting at start
+    [[nodiscard]] std::size_t next_line(std::size_t start) const {
+        const auto *data = file_->data();
+        auto size        = file_->size();
+        const auto *nl =
+            (const char *)std::memchr(data + start, '\n', size - start);
+        return nl ? (std::size_t)(nl - data) + 1 : size;
+    }
+
+  public:
+    explicit LineIndex(
+        std::shared_ptr<const MappedFile> file, std::size_t stride = 64
+    )
+        : file_(std::move(file)), stride_(std::max<std::size_t>(stride, 1)),
+          worker_([this](const std::stop_token &st) { run(st); }) {}
+    LineIndex(const LineIndex &)            = delete;
+    LineIndex &operator=(const LineIndex &) = delete;
+    /// Number of lines indexed so far
+    [[nodiscard]] std::size_t lines() const { return lines_; }
+    /// Whether the whole file has been indexed
+    [[nodiscard]] bool done() const { return done_; }
+    [[nodiscard]] const MappedFile &file() const { return *file_; }
+    /// Call f(i, text) for each indexed line in [first, first + n)
+    template <class F>
+    void visit(std::size_t first, std::size_t n, F &&f) const {
+        auto count = lines();
+        if (first >= count)
+            return;
+        n = std::min(n, count - first);
+        std::size_t start;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            start = starts_[first / stride_];
+        }
+        const auto *data = file_->data();
+        for (auto i = first - first % stride_; i < first; i++)
+            start = next_line(start);
+        for (auto i = first; i < first + n; i++) {
+            auto next = next_line(start);
+            auto end  = next;
+            if (end > start && data[end - 1] == '\n')
+                end--;
+            if (end > start && data[end - 1] == '\r')
+                end--;
+            f(i, std::string_view(data + start, end - start));
+            start = next;
+        }
+    }
+    /// Get a single line
+    [[nodiscard]] std::string_view line(std::size_t i) const {
+        std::string_view ret;
+        visit(i, 1, [&](std::size_t, std::string_view s) { ret = s; });
+        return ret;
+    }
+};
+} // namespace rf::detail
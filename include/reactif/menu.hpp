@@ -1,18 +1,69 @@
 #pragma once
 
+#include "handler.hpp"
 #include "widget.hpp"
 #include <FL/Fl_Choice.H>
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/Fl_Sys_Menu_Bar.H>
+#include <algorithm>
 #include <span>
+#include <string_view>
 
 namespace rf::detail {
+
+/// Position of the first (or last) unescaped '/' in a menu path
+inline std::string::size_type
+menu_separator(std::string_view path, bool last = false) {
+    auto found = std::string::npos;
+    for (std::string::size_type i = 0; i < path.size(); i++) {
+        if (path[i] == '\\') {
+            i++;
+        } else if (path[i] == '/') {
+            found = i;
+            if (!last)
+                break;
+        }
+    }
+    return found;
+}
+
+/// The top-level submenu an item lives in, or "" for root items
+inline std::string_view menu_root(std::string_view path) {
+    auto i = menu_separator(path);
+    return i == std::string::npos ? std::string_view() : path.substr(0, i);
+}
+
+/// Everything before the item's own name
+inline std::string_view menu_parent(std::string_view path) {
+    auto i = menu_separator(path, true);
+    return i == std::string::npos ? std::string_view() : path.substr(0, i);
+}
+
+/// A path segment as FLTK stores it, without escapes
+inline std::string menu_unescape(std::string_view name) {
+    std::string ret;
+    for (std::string::size_type i = 0; i < name.size(); i++) {
+        if (name[i] == '\\' && i + 1 < name.size())
+            i++;
+        ret += name[i];
+    }
+    return ret;
+}
+
+/// The item's own name
+inline std::string menu_leaf(std::string_view path) {
+    auto i = menu_separator(path, true);
+    return menu_unescape(
+        i == std::string::npos ? path : path.substr(i + 1)
+    );
+}
+
 template <class Message>
 class MenuItem {
     std::string label_;
     std::optional<Shortcut> shortcut_;
     std::optional<MenuFlag> flag_;
-    std::optional<std::shared_ptr<std::function<Message()>>> on_trigger_;
+    Handler<Message> on_trigger_;
     std::optional<int> labelsize_;
 
   public:
@@ -33,68 +84,208 @@ class MenuItem {
         return *this;
     }
     /// Set the callback trigger
-    MenuItem &on_trigger(std::function<Message()> &&msg) {
-        on_trigger_ =
-            std::make_shared<std::function<Message()>>(std::move(msg));
+    MenuItem &on_trigger(Handler<Message> msg) {
+        on_trigger_ = std::move(msg);
         return *this;
     }
+    /// Get the item's path
+    [[nodiscard]] const std::string &label() const { return label_; }
     bool operator==(const MenuItem &) const = default;
-    void view(Fl_Menu_ *m) const {
+    void hash(Hasher &h) const {
+        h(label_, shortcut_, flag_, on_trigger_, labelsize_);
+    }
+    /// Add the entry, returning its index in the menu array
+    int view(Fl_Menu_ *m) const {
         auto i = m->add(
             label_.c_str(),
             shortcut_ ? (int)*shortcut_ : 0,
             on_trigger_ ? [](Fl_Widget *, void *data) { Fl::awake(data); }
                         : [](auto, auto) {},
-            on_trigger_ ? on_trigger_->get() : 0,
+            on_trigger_ ? (void *)&on_trigger_ : nullptr,
             flag_ ? (int)*flag_ : 0
         );
         auto menu = (Fl_Menu_Item *)m->menu(); // NOLINT
         if (labelsize_)
             menu[i].labelsize(*labelsize_);
+        return i;
     }
-    void update(Fl_Menu_ *w, const MenuItem &other) {
-        auto i = w->add(
-            label_.c_str(),
-            shortcut_ ? (int)*shortcut_ : 0,
-            on_trigger_ ? [](Fl_Widget *, void *data) { Fl::awake(data); }
-                        : [](auto, auto) {},
-            on_trigger_ ? on_trigger_->get() : 0,
-            flag_ ? (int)*flag_ : 0
+    /// Patch the existing entry at index in place, without re-adding it.
+    /// other must outlive the entry.
+    void update(Fl_Menu_ *w, int index, const MenuItem &other) {
+        auto item = (Fl_Menu_Item *)&w->menu()[index]; // NOLINT
+        if (other.label_ != label_)
+            w->replace(index, menu_leaf(other.label_).c_str());
+        if (other.shortcut_ != shortcut_)
+            w->shortcut(index, other.shortcut_ ? (int)*other.shortcut_ : 0);
+        if (other.flag_ != flag_)
+            w->mode(index, other.flag_ ? (int)*other.flag_ : 0);
+        // The entry's user data points at the handler, which lives in other
+        // from now on, so it is rebound even when the handlers are equal
+        item->callback(
+            other.on_trigger_
+                ? [](Fl_Widget *, void *data) { Fl::awake(data); }
+                : [](auto, auto) {},
+            other.on_trigger_ ? (void *)&other.on_trigger_ : nullptr
         );
-        auto menu = (Fl_Menu_Item *)w->menu(); // NOLINT
-        if (labelsize_)
-            menu[i].labelsize(*labelsize_);
+        if (other.labelsize_ != labelsize_)
+            item->labelsize(other.labelsize_ ? *other.labelsize_ : 0);
+        *this = other;
     }
 };
 
 template <class Message, class B>
 struct MenuProps {
     std::vector<MenuItem<Message>> items;
+    /// Index of each item in the menu array
+    std::vector<int> indices;
     void view(B *w) {
-        if (!items.empty()) {
-            for (const auto &i : items) {
-                i.view(w);
-            }
-        }
+        indices.assign(items.size(), -1);
+        for (std::size_t i = 0; i < items.size(); i++)
+            add(w, i);
     }
     void update(B *w, const MenuProps &other) {
         if (*this == other)
             return;
-        if (other.items != items) {
-            w->clear();
-            items = other.items;
-            for (auto i = 0; i < items.size(); i++) {
-                items[i].update(w, other.items[i]);
+        auto old_groups = groups();
+        auto new_groups = other.groups();
+        if (!same_keys(old_groups, new_groups)) {
+            rebuild(w, other);
+            return;
+        }
+        auto old_items = std::move(items);
+        items          = other.items;
+        // Patch in place first: rebuilding a submenu shifts every entry
+        // after it, which would leave the indices of later groups stale
+        std::vector<int> next(items.size(), -1);
+        std::vector<std::size_t> changed;
+        for (std::size_t g = 0; g < old_groups.size(); g++) {
+            const auto &o = old_groups[g].second;
+            const auto &n = new_groups[g].second;
+            if (!same_shape(old_items, o, n)) {
+                changed.push_back(g);
+                continue;
+            }
+            for (std::size_t k = 0; k < o.size(); k++) {
+                auto index = indices[o[k]];
+                if (index >= 0)
+                    old_items[o[k]].update(w, index, items[n[k]]);
+                next[n[k]] = index;
             }
         }
+        indices = std::move(next);
+        // Only the submenus that changed shape get rebuilt
+        for (auto g : changed) {
+            auto index = find_root(w, new_groups[g].first);
+            if (index < 0) {
+                rebuild(w, other);
+                return;
+            }
+            auto before = w->size();
+            w->clear_submenu(index);
+            shift(index + 1, w->size() - before);
+            for (auto i : new_groups[g].second)
+                add(w, i);
+        }
+    }
+    bool operator==(const MenuProps &other) const {
+        return items == other.items;
+    }
+    void hash(Hasher &h) const { h(items); }
+
+  private:
+    using Groups =
+        std::vector<std::pair<std::string_view, std::vector<std::size_t>>>;
+    /// Items grouped by top-level submenu, in order of first appearance
+    [[nodiscard]] Groups groups() const {
+        Groups ret;
+        for (std::size_t i = 0; i < items.size(); i++) {
+            auto key = menu_root(items[i].label());
+            auto it  = std::find_if(ret.begin(), ret.end(), [&](auto &g) {
+                return g.first == key;
+            });
+            if (it == ret.end())
+                ret.push_back({key, {i}});
+            else
+                it->second.push_back(i);
+        }
+        return ret;
+    }
+    static bool same_keys(const Groups &a, const Groups &b) {
+        return std::equal(
+            a.begin(),
+            a.end(),
+            b.begin(),
+            b.end(),
+            [](auto &x, auto &y) { return x.first == y.first; }
+        );
+    }
+    /// Whether a group can be patched in place: same item count, and every
+    /// item keeps its parent path so that at most its own name changes
+    bool same_shape(
+        const std::vector<MenuItem<Message>> &old_items,
+        const std::vector<std::size_t> &o,
+        const std::vector<std::size_t> &n
+    ) const {
+        if (o.size() != n.size())
+            return false;
+        for (std::size_t k = 0; k < o.size(); k++) {
+            if (indices[o[k]] < 0 ||
+                menu_parent(old_items[o[k]].label()) !=
+                    menu_parent(items[n[k]].label()))
+                return false;
+        }
+        return true;
+    }
+    void rebuild(B *w, const MenuProps &other) {
+        w->clear();
+        items = other.items;
+        view(w);
+    }
+    /// Move the recorded indices from first on by n entries
+    void shift(int first, int n) {
+        if (n == 0)
+            return;
+        for (auto &index : indices)
+            if (index >= first)
+                index += n;
+    }
+    /// Add item i, recording the index add() returns. The entries inserted
+    /// move those after them: a new submenu puts its title before the item
+    /// and its end after it.
+    void add(B *w, std::size_t i) {
+        auto before = w->size();
+        auto index  = items[i].view(w);
+        auto added  = w->size() - before;
+        shift(index - (added > 0 ? (added - 1) / 2 : 0), added);
+        indices[i] = index;
+    }
+    /// The index of the top-level submenu named by a path segment, or -1
+    static int find_root(B *w, std::string_view key) {
+        if (key.empty() || !w->menu())
+            return -1;
+        auto name = menu_unescape(key);
+        if (!name.empty() && name[0] == '_')
+            name.erase(0, 1);
+        const auto *menu = w->menu();
+        for (const auto *m = menu; m->text; m = m->next())
+            if (m->submenu() && name == m->text)
+                return (int)(m - menu);
+        return -1;
     }
-    bool operator==(const MenuProps &) const = default;
 };
 
 template <class Message, class W, class B>
 class MenuBase : public WidgetBase<Message, W, B> {
   protected:
     MenuProps<Message, B> mprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        mprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               mprops == other.mprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -48,12 +48,21 @@ struct OutputProps {
         }
     }
     bool operator==(const OutputProps &) const = default;
+    void hash(Hasher &h) const { h(value, textcolor, textfont, textsize); }
 };
 
 template <class Message, class W, class B>
 class OutputBase : public WidgetBase<Message, W, B> {
   protected:
     OutputProps<B> oprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        oprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               oprops == other.oprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
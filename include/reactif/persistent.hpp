@@ -0,0 +1,541 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rf {
+
+/// An immutable vector with structural sharing: a 32-way trie of leaves plus
+/// a tail, as in Clojure's vectors. Modifying operations return a new vector
+/// sharing all untouched leaves with the old one, so copies are O(1),
+/// snapshots can be read from other threads without locking, and
+/// identical() tells in O(1) whether anything changed.
+template <class T>
+class PersistentVector {
+    static constexpr unsigned bits  = 5;
+    static constexpr std::size_t width = 1 << bits;
+    static constexpr std::size_t mask  = width - 1;
+
+    struct Node {
+        std::vector<std::shared_ptr<const Node>> children;
+        std::vector<T> values;
+    };
+    using NodePtr = std::shared_ptr<const Node>;
+
+    std::size_t size_ = 0;
+    unsigned shift_   = bits;
+    NodePtr root_     = empty_node();
+    NodePtr tail_     = empty_node();
+
+    static const NodePtr &empty_node() {
+        static const NodePtr empty = std::make_shared<const Node>();
+        return empty;
+    }
+    [[nodiscard]] std::size_t tail_offset() const {
+        return size_ < width ? 0 : ((size_ - 1) >> bits) << bits;
+    }
+    [[nodiscard]] const Node *leaf_for(std::size_t i) const {
+        if (i >= tail_offset())
+            return tail_.get();
+        const Node *node = root_.get();
+        for (auto level = shift_; level > 0; level -= bits)
+            node = node->children[(i >> level) & mask].get();
+        return node;
+    }
+    static NodePtr new_path(unsigned level, NodePtr node) {
+        if (level == 0)
+            return node;
+        auto ret = std::make_shared<Node>();
+        ret->children.push_back(new_path(level - bits, std::move(node)));
+        return ret;
+    }
+    NodePtr push_tail(unsigned level, const Node &parent, NodePtr tail) const {
+        auto ret    = std::make_shared<Node>(parent);
+        auto subidx = ((size_ - 1) >> level) & mask;
+        NodePtr insert;
+        if (level == bits)
+            insert = std::move(tail);
+        else if (subidx < parent.children.size())
+            insert = push_tail(level - bits, *parent.children[subidx], tail);
+        else
+            insert = new_path(level - bits, std::move(tail));
+        if (subidx < ret->children.size())
+            ret->children[subidx] = std::move(insert);
+        else
+            ret->children.push_back(std::move(insert));
+        return ret;
+    }
+    static NodePtr
+    assoc(unsigned level, const Node &node, std::size_t i, const T &value) {
+        auto ret = std::make_shared<Node>(node);
+        if (level == 0) {
+            ret->values[i & mask] = value;
+        } else {
+            auto sub = (i >> level) & mask;
+            ret->children[sub] =
+                assoc(level - bits, *node.children[sub], i, value);
+        }
+        return ret;
+    }
+    NodePtr pop_tail(unsigned level, const Node &node) const {
+        auto subidx = ((size_ - 2) >> level) & mask;
+        if (level > bits) {
+            auto child = pop_tail(level - bits, *node.children[subidx]);
+            if (!child && subidx == 0)
+                return nullptr;
+            auto ret = std::make_shared<Node>(node);
+            if (child)
+                ret->children[subidx] = std::move(child);
+            else
+                ret->children.resize(subidx);
+            return ret;
+        }
+        if (subidx == 0)
+            return nullptr;
+        auto ret = std::make_shared<Node>(node);
+        ret->children.resize(subidx);
+        return ret;
+    }
+
+  public:
+    using value_type = T;
+
+    class const_iterator {
+        const PersistentVector *vec_ = nullptr;
+        std::size_t i_               = 0;
+        mutable const Node *leaf_    = nullptr;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const T *;
+        using reference         = const T &;
+        const_iterator()        = default;
+        const_iterator(const PersistentVector *vec, std::size_t i)
+            : vec_(vec), i_(i) {}
+        reference operator*() const {
+            if (!leaf_)
+                leaf_ = vec_->leaf_for(i_);
+            return leaf_->values[i_ & mask];
+        }
+        pointer operator->() const { return &**this; }
+        const_iterator &operator++() {
+            i_++;
+            if ((i_ & mask) == 0)
+                leaf_ = nullptr;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto ret = *this;
+            ++*this;
+            return ret;
+        }
+        bool operator==(const const_iterator &other) const {
+            return i_ == other.i_;
+        }
+    };
+
+    PersistentVector() = default;
+    PersistentVector(std::initializer_list<T> values) {
+        for (const auto &v : values)
+            *this = push_back(v);
+    }
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    const T &operator[](std::size_t i) const {
+        return leaf_for(i)->values[i & mask];
+    }
+    [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const { return {this, size_}; }
+
+    /// Whether both share the same structure, i.e. nothing changed between
+    /// them. Equal contents built separately are not identical.
+    [[nodiscard]] bool identical(const PersistentVector &other) const {
+        return size_ == other.size_ && root_ == other.root_ &&
+               tail_ == other.tail_;
+    }
+    /// A copy with value appended
+    [[nodiscard]] PersistentVector push_back(T value) const {
+        auto ret = *this;
+        if (size_ - tail_offset() < width) {
+            auto tail = std::make_shared<Node>(*tail_);
+            tail->values.push_back(std::move(value));
+            ret.tail_ = std::move(tail);
+        } else {
+            if ((size_ >> bits) > (std::size_t(1) << shift_)) {
+                auto root = std::make_shared<Node>();
+                root->children.push_back(root_);
+                root->children.push_back(new_path(shift_, tail_));
+                ret.root_ = std::move(root);
+                ret.shift_ += bits;
+            } else {
+                ret.root_ = push_tail(shift_, *root_, tail_);
+            }
+            auto tail = std::make_shared<Node>();
+            tail->values.reserve(width);
+            tail->values.push_back(std::move(value));
+            ret.tail_ = std::move(tail);
+        }
+        ret.size_++;
+        return ret;
+    }
+    /// A copy with element i replaced
+    [[nodiscard]] PersistentVector set(std::size_t i, const T &value) const {
+        auto ret = *this;
+        if (i >= tail_offset()) {
+            auto tail              = std::make_shared<Node>(*tail_);
+            tail->values[i & mask] = value;
+            ret.tail_              = std::move(tail);
+        } else {
+            ret.root_ = assoc(shift_, *root_, i, value);
+        }
+        return ret;
+    }
+    /// A copy without the last element
+    [[nodiscard]] PersistentVector pop_back() const {
+        if (size_ <= 1)
+            return {};
+        auto ret = *this;
+        if (size_ - tail_offset() > 1) {
+            auto tail = std::make_shared<Node>(*tail_);
+            tail->values.pop_back();
+            ret.tail_ = std::move(tail);
+        } else {
+            // The last leaf of the trie becomes the tail
+            const auto *leaf = leaf_for(size_ - 2);
+            ret.tail_        = std::make_shared<Node>(*leaf);
+            auto root        = pop_tail(shift_, *root_);
+            if (!root)
+                root = empty_node();
+            if (shift_ > bits && root->children.size() == 1) {
+                root = root->children[0];
+                ret.shift_ -= bits;
+            }
+            ret.root_ = std::move(root);
+        }
+        ret.size_--;
+        return ret;
+    }
+    /// A copy holding the first n elements, sharing their leaves
+    [[nodiscard]] PersistentVector take(std::size_t n) const {
+        auto ret = *this;
+        while (ret.size() > n)
+            ret = ret.pop_back();
+        return ret;
+    }
+    /// A copy without element i; leaves before it stay shared
+    [[nodiscard]] PersistentVector erase(std::size_t i) const {
+        auto ret = take(i);
+        for (auto j = i + 1; j < size_; j++)
+            ret = ret.push_back((*this)[j]);
+        return ret;
+    }
+    /// Call f(chunk, values, offset) for each leaf in order. A leaf is the
+    /// same chunk across versions for as long as it is unchanged, so callers
+    /// holding on to chunks can skip work for slices they have already seen.
+    template <class F>
+    void for_each_chunk(F &&f) const {
+        auto tail = tail_offset();
+        for (std::size_t i = 0; i < tail; i += width) {
+            const NodePtr *node = &root_;
+            for (auto level = shift_; level > 0; level -= bits)
+                node = &(*node)->children[(i >> level) & mask];
+            f(std::shared_ptr<const void>(*node),
+              std::span<const T>((*node)->values),
+              i);
+        }
+        if (!tail_->values.empty())
+            f(std::shared_ptr<const void>(tail_),
+              std::span<const T>(tail_->values),
+              tail);
+    }
+};
+
+/// An immutable hash map with structural sharing, stored as a compressed
+/// hash array mapped trie. Updates copy only the path to the changed entry,
+/// and identical() tells in O(1) whether anything changed.
+template <class K, class V, class Hash = std::hash<K>>
+class PersistentMap {
+    static constexpr unsigned bits      = 5;
+    static constexpr unsigned hash_bits = sizeof(std::size_t) * 8;
+
+    struct Node {
+        std::uint32_t datamap = 0;
+        std::uint32_t nodemap = 0;
+        /// Entries inline in this node; past the last level, all colliding
+        /// entries in no particular order
+        std::vector<std::pair<K, V>> entries;
+        std::vector<std::shared_ptr<const Node>> nodes;
+    };
+    using NodePtr = std::shared_ptr<const Node>;
+
+    NodePtr root_     = std::make_shared<const Node>();
+    std::size_t size_ = 0;
+
+    static std::uint32_t bit_for(std::size_t hash, unsigned shift) {
+        return std::uint32_t(1) << ((hash >> shift) & 31);
+    }
+    static std::size_t index(std::uint32_t map, std::uint32_t bit) {
+        return (std::size_t)std::popcount(map & (bit - 1));
+    }
+    static NodePtr merge(
+        std::pair<K, V> a,
+        std::size_t ha,
+        std::pair<K, V> b,
+        std::size_t hb,
+        unsigned shift
+    ) {
+        auto node = std::make_shared<Node>();
+        if (shift >= hash_bits) {
+            node->entries.push_back(std::move(a));
+            node->entries.push_back(std::move(b));
+            return node;
+        }
+        auto ba = bit_for(ha, shift);
+        auto bb = bit_for(hb, shift);
+        if (ba == bb) {
+            node->nodemap = ba;
+            node->nodes.push_back(
+                merge(std::move(a), ha, std::move(b), hb, shift + bits)
+            );
+        } else {
+            node->datamap = ba | bb;
+            if (ba < bb) {
+                node->entries.push_back(std::move(a));
+                node->entries.push_back(std::move(b));
+            } else {
+                node->entries.push_back(std::move(b));
+                node->entries.push_back(std::move(a));
+            }
+        }
+        return node;
+    }
+    static NodePtr insert(
+        const Node &node,
+        std::size_t hash,
+        unsigned shift,
+        const K &key,
+        V value,
+        bool &added
+    ) {
+        auto ret = std::make_shared<Node>(node);
+        if (shift >= hash_bits) {
+            for (auto &e : ret->entries) {
+                if (e.first == key) {
+                    e.second = std::move(value);
+                    return ret;
+                }
+            }
+            ret->entries.emplace_back(key, std::move(value));
+            added = true;
+            return ret;
+        }
+        auto bit = bit_for(hash, shift);
+        if (node.datamap & bit) {
+            auto i = index(node.datamap, bit);
+            if (node.entries[i].first == key) {
+                ret->entries[i].second = std::move(value);
+                return ret;
+            }
+            auto other = std::move(ret->entries[i]);
+            auto oh    = Hash()(other.first);
+            ret->entries.erase(ret->entries.begin() + (std::ptrdiff_t)i);
+            ret->datamap ^= bit;
+            ret->nodemap |= bit;
+            ret->nodes.insert(
+                ret->nodes.begin() + (std::ptrdiff_t)index(ret->nodemap, bit),
+                merge(
+                    std::move(other),
+                    oh,
+                    {key, std::move(value)},
+                    hash,
+                    shift + bits
+                )
+            );
+            added = true;
+        } else if (node.nodemap & bit) {
+            auto i        = index(node.nodemap, bit);
+            ret->nodes[i] = insert(
+                *node.nodes[i], hash, shift + bits, key, std::move(value), added
+            );
+        } else {
+            ret->datamap |= bit;
+            ret->entries.insert(
+                ret->entries.begin() + (std::ptrdiff_t)index(ret->datamap, bit),
+                {key, std::move(value)}
+            );
+            added = true;
+        }
+        return ret;
+    }
+    static NodePtr remove(
+        const NodePtr &node, std::size_t hash, unsigned shift, const K &key
+    ) {
+        if (shift >= hash_bits) {
+            for (std::size_t i = 0; i < node->entries.size(); i++) {
+                if (node->entries[i].first == key) {
+                    auto ret = std::make_shared<Node>(*node);
+                    ret->entries.erase(
+                        ret->entries.begin() + (std::ptrdiff_t)i
+                    );
+                    return ret;
+                }
+            }
+            return node;
+        }
+        auto bit = bit_for(hash, shift);
+        if (node->datamap & bit) {
+            auto i = index(node->datamap, bit);
+            if (!(node->entries[i].first == key))
+                return node;
+            auto ret = std::make_shared<Node>(*node);
+            ret->entries.erase(ret->entries.begin() + (std::ptrdiff_t)i);
+            ret->datamap ^= bit;
+            return ret;
+        }
+        if (!(node->nodemap & bit))
+            return node;
+        auto i   = index(node->nodemap, bit);
+        auto sub = remove(node->nodes[i], hash, shift + bits, key);
+        if (sub == node->nodes[i])
+            return node;
+        auto ret = std::make_shared<Node>(*node);
+        if (sub->nodes.empty() && sub->entries.size() <= 1) {
+            // Keep the trie canonical by pulling a lone entry up a level
+            ret->nodes.erase(ret->nodes.begin() + (std::ptrdiff_t)i);
+            ret->nodemap ^= bit;
+            if (!sub->entries.empty()) {
+                ret->datamap |= bit;
+                ret->entries.insert(
+                    ret->entries.begin() +
+                        (std::ptrdiff_t)index(ret->datamap, bit),
+                    sub->entries[0]
+                );
+            }
+        } else {
+            ret->nodes[i] = std::move(sub);
+        }
+        return ret;
+    }
+    template <class F>
+    static void visit(const Node &node, F &f) {
+        for (const auto &[k, v] : node.entries)
+            f(k, v);
+        for (const auto &n : node.nodes)
+            visit(*n, f);
+    }
+
+  public:
+    PersistentMap() = default;
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    /// Whether both share the same structure, i.e. nothing changed between
+    /// them
+    [[nodiscard]] bool identical(const PersistentMap &other) const {
+        return root_ == other.root_;
+    }
+    /// The value for key, or nullptr
+    [[nodiscard]] const V *find(const K &key) const {
+        auto hash        = Hash()(key);
+        const Node *node = root_.get();
+        for (unsigned shift = 0;; shift += bits) {
+            if (shift >= hash_bits) {
+                for (const auto &e : node->entries)
+                    if (e.first == key)
+                        return &e.second;
+                return nullptr;
+            }
+            auto bit = bit_for(hash, shift);
+            if (node->datamap & bit) {
+                const auto &e = node->entries[index(node->datamap, bit)];
+                return e.first == key ? &e.second : nullptr;
+            }
+            if (!(node->nodemap & bit))
+                return nullptr;
+            node = node->nodes[index(node->nodemap, bit)].get();
+        }
+    }
+    [[nodiscard]] bool contains(const K &key) const {
+        return find(key) != nullptr;
+    }
+    /// A copy with key mapped to value
+    [[nodiscard]] PersistentMap set(const K &key, V value) const {
+        auto ret   = *this;
+        bool added = false;
+        ret.root_ =
+            insert(*root_, Hash()(key), 0, key, std::move(value), added);
+        if (added)
+            ret.size_++;
+        return ret;
+    }
+    /// A copy without key; the same map if it was not present
+    [[nodiscard]] PersistentMap erase(const K &key) const {
+        auto ret  = *this;
+        ret.root_ = remove(root_, Hash()(key), 0, key);
+        if (ret.root_ != root_)
+            ret.size_--;
+        return ret;
+    }
+    /// Call f(key, value) for each entry, in no particular order
+    template <class F>
+    void for_each(F &&f) const {
+        visit(*root_, f);
+    }
+};
+
+/// Caches what was built for each chunk of a PersistentVector, so that a
+/// view only rebuilds the slices that changed since the previous one.
+/// With widget nodes as Item, reused nodes are the same pointers as before,
+/// which the reconciler skips without comparing them. Since the memo holds
+/// them, they are mounted as built and never updated to another row's props.
+template <class Item>
+class ChunkMemo {
+    struct Chunk {
+        /// Keeps the chunk alive so its address is not reused as a key
+        std::shared_ptr<const void> hold;
+        std::vector<Item> items;
+    };
+    std::unordered_map<const void *, Chunk> chunks_;
+
+  public:
+    /// Build items for v, calling f(value, index) only for elements in
+    /// changed chunks
+    template <class T, class F>
+    std::vector<Item> build(const PersistentVector<T> &v, F &&f) {
+        std::unordered_map<const void *, Chunk> next;
+        std::vector<Item> out;
+        out.reserve(v.size());
+        v.for_each_chunk([&](std::shared_ptr<const void> chunk,
+                             std::span<const T> values,
+                             std::size_t offset) {
+            auto *id = chunk.get();
+            auto it  = chunks_.find(id);
+            if (it != chunks_.end()) {
+                it = next.emplace(id, std::move(it->second)).first;
+            } else {
+                Chunk c{std::move(chunk), {}};
+                c.items.reserve(values.size());
+                for (std::size_t i = 0; i < values.size(); i++)
+                    c.items.push_back(f(values[i], offset + i));
+                it = next.emplace(id, std::move(c)).first;
+            }
+            const auto &items = it->second.items;
+            out.insert(out.end(), items.begin(), items.end());
+        });
+        chunks_ = std::move(next);
+        return out;
+    }
+    /// Forget all chunks, so the next build() starts over
+    void clear() { chunks_.clear(); }
+};
+} // namespace rf
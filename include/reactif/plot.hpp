@@ -0,0 +1,466 @@
+#pragma once
+
+#include "widget.hpp"
+#include <FL/Enumerations.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Box.H>
+#include <FL/fl_draw.H>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define REACTIF_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define REACTIF_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace rf {
+
+/// A series drawn by plot(). The samples are referenced, not copied, and
+/// must outlive the widget or the next view.
+struct PlotSeries {
+    std::span<const double> data;
+    Color color = Color::Blue;
+    bool operator==(const PlotSeries &other) const {
+        return data.data() == other.data.data() &&
+               data.size() == other.data.size() &&
+               (uint32_t)color == (uint32_t)other.color;
+    }
+    void hash(detail::Hasher &h) const {
+        h((std::uintptr_t)data.data(), data.size(), (uint32_t)color);
+    }
+};
+
+namespace detail {
+
+/// The minimum and maximum of n > 0 samples
+inline std::pair<double, double> minmax(const double *p, std::size_t n) {
+    double lo     = p[0];
+    double hi     = p[0];
+    std::size_t i = 0;
+#if defined(REACTIF_SIMD_SSE2)
+    if (n >= 4) {
+        __m128d lo0 = _mm_loadu_pd(p);
+        __m128d lo1 = _mm_loadu_pd(p + 2);
+        __m128d hi0 = lo0;
+        __m128d hi1 = lo1;
+        for (i = 4; i + 4 <= n; i += 4) {
+            __m128d a = _mm_loadu_pd(p + i);
+            __m128d b = _mm_loadu_pd(p + i + 2);
+            lo0       = _mm_min_pd(lo0, a);
+            hi0       = _mm_max_pd(hi0, a);
+            lo1       = _mm_min_pd(lo1, b);
+            hi1       = _mm_max_pd(hi1, b);
+        }
+        alignas(16) double l[2];
+        alignas(16) double h[2];
+        _mm_store_pd(l, _mm_min_pd(lo0, lo1));
+        _mm_store_pd(h, _mm_max_pd(hi0, hi1));
+        lo = std::min(l[0], l[1]);
+        hi = std::max(h[0], h[1]);
+    }
+#elif defined(REACTIF_SIMD_NEON)
+    if (n >= 4) {
+        float64x2_t lo0 = vld1q_f64(p);
+        float64x2_t lo1 = vld1q_f64(p + 2);
+        float64x2_t hi0 = lo0;
+        float64x2_t hi1 = lo1;
+        for (i = 4; i + 4 <= n; i += 4) {
+            float64x2_t a = vld1q_f64(p + i);
+            float64x2_t b = vld1q_f64(p + i + 2);
+            lo0           = vminq_f64(lo0, a);
+            hi0           = vmaxq_f64(hi0, a);
+            lo1           = vminq_f64(lo1, b);
+            hi1           = vmaxq_f64(hi1, b);
+        }
+        lo = vminvq_f64(vminq_f64(lo0, lo1));
+        hi = vmaxvq_f64(vmaxq_f64(hi0, hi1));
+    }
+#endif
+    for (; i < n; i++) {
+        lo = std::min(lo, p[i]);
+        hi = std::max(hi, p[i]);
+    }
+    return {lo, hi};
+}
+
+/// Min/max levels of detail of a series, one per power-of-two zoom level.
+/// Level k holds a pair per 2^(base + k) samples; levels are built on first
+/// use, each from the one below, so a redraw only touches about one pair
+/// per pixel column whatever the zoom.
+class MinMaxPyramid {
+    using Level = std::vector<std::pair<double, double>>;
+    std::span<const double> data_;
+    std::uint64_t revision_ = 0;
+    std::vector<Level> levels_;
+
+  public:
+    static constexpr unsigned base = 6;
+
+    /// Point at a series, dropping the cached levels if it changed
+    void reset(std::span<const double> data, std::uint64_t revision) {
+        if (data.data() == data_.data() && data.size() == data_.size() &&
+            revision == revision_)
+            return;
+        data_     = data;
+        revision_ = revision;
+        levels_.clear();
+    }
+    [[nodiscard]] std::size_t size() const { return data_.size(); }
+    const Level &level(std::size_t k) {
+        while (levels_.size() <= k) {
+            Level next;
+            if (levels_.empty()) {
+                auto step = std::size_t(1) << base;
+                next.reserve((data_.size() + step - 1) / step);
+                for (std::size_t i = 0; i < data_.size(); i += step)
+                    next.push_back(minmax(
+                        data_.data() + i, std::min(step, data_.size() - i)
+                    ));
+            } else {
+                const auto &prev = levels_.back();
+                next.reserve((prev.size() + 1) / 2);
+                for (std::size_t i = 0; i < prev.size(); i += 2) {
+                    auto pair = prev[i];
+                    if (i + 1 < prev.size()) {
+                        pair.first  = std::min(pair.first, prev[i + 1].first);
+                        pair.second = std::max(pair.second, prev[i + 1].second);
+                    }
+                    next.push_back(pair);
+                }
+            }
+            levels_.push_back(std::move(next));
+        }
+        return levels_[k];
+    }
+    /// Reduce samples [first, last) to one min/max pair per column.
+    /// Above 2^base samples per column, columns snap outwards to the
+    /// boundaries of the level used.
+    void decimate(
+        std::size_t first,
+        std::size_t last,
+        std::size_t columns,
+        std::vector<std::pair<double, double>> &out
+    ) {
+        out.clear();
+        if (first >= last || columns == 0)
+            return;
+        auto n   = last - first;
+        auto spp = n / columns;
+        out.reserve(columns);
+        if (spp < (std::size_t(1) << base)) {
+            for (std::size_t c = 0; c < columns; c++) {
+                auto s = first + c * n / columns;
+                auto e = std::max(first + (c + 1) * n / columns, s + 1);
+                out.push_back(minmax(data_.data() + s, e - s));
+            }
+            return;
+        }
+        std::size_t k = 0;
+        while ((std::size_t(2) << (base + k)) <= spp)
+            k++;
+        const auto &lv = level(k);
+        auto shift     = base + k;
+        for (std::size_t c = 0; c < columns; c++) {
+            auto s    = (first + c * n / columns) >> shift;
+            auto e    = ((first + (c + 1) * n / columns - 1) >> shift) + 1;
+            auto pair = lv[s];
+            for (auto i = s + 1; i < std::min(e, lv.size()); i++) {
+                pair.first  = std::min(pair.first, lv[i].first);
+                pair.second = std::max(pair.second, lv[i].second);
+            }
+            out.push_back(pair);
+        }
+    }
+};
+
+/// A line plot of large series. Each series is reduced to a min/max pair
+/// per pixel column, so drawing costs scale with the width rather than the
+/// sample count. The wheel zooms around the pointer, dragging pans and a
+/// double click shows everything again.
+class PlotDisplay : public Fl_Box {
+    std::vector<PlotSeries> series_;
+    std::vector<MinMaxPyramid> pyramids_;
+    std::vector<std::vector<std::pair<double, double>>> columns_;
+    std::uint64_t revision_ = 0;
+    std::size_t first_      = 0;
+    std::size_t last_       = 0;
+    bool yauto_             = true;
+    double ymin_            = 0;
+    double ymax_            = 1;
+    int drag_x_             = 0;
+    std::size_t drag_first_ = 0;
+
+    [[nodiscard]] std::size_t samples() const {
+        std::size_t n = 0;
+        for (const auto &s : series_)
+            n = std::max(n, s.data.size());
+        return n;
+    }
+    /// The visible sample range, clamped to the data
+    [[nodiscard]] std::pair<std::size_t, std::size_t> range() const {
+        auto n     = samples();
+        auto last  = last_ ? std::min(last_, n) : n;
+        auto first = std::min(first_, last);
+        return {first, last};
+    }
+
+  protected:
+    void draw() override {
+        draw_box();
+        auto X = x() + Fl::box_dx(box());
+        auto Y = y() + Fl::box_dy(box());
+        auto W = w() - Fl::box_dw(box());
+        auto H = h() - Fl::box_dh(box());
+        auto [first, last] = range();
+        if (W <= 1 || H <= 1 || first >= last)
+            return;
+        auto n = last - first;
+        columns_.resize(series_.size());
+        auto lo = yauto_ ? INFINITY : ymin_;
+        auto hi = yauto_ ? -INFINITY : ymax_;
+        for (std::size_t i = 0; i < series_.size(); i++) {
+            auto end  = std::min(last, series_[i].data.size());
+            auto cols = first < end ? (end - first) * (std::size_t)W / n : 0;
+            if (n > (std::size_t)W)
+                pyramids_[i].decimate(first, end, cols, columns_[i]);
+            else
+                columns_[i].clear();
+            if (!yauto_)
+                continue;
+            for (const auto &[l, h] : columns_[i]) {
+                lo = std::min(lo, l);
+                hi = std::max(hi, h);
+            }
+            if (n <= (std::size_t)W && first < end) {
+                const auto *p = series_[i].data.data() + first;
+                auto [l, h]   = minmax(p, end - first);
+                lo            = std::min(lo, l);
+                hi            = std::max(hi, h);
+            }
+        }
+        if (!(hi > lo)) {
+            lo -= 1;
+            hi += 1;
+        }
+        auto py = [&](double v) {
+            return Y + (int)std::lround((hi - v) / (hi - lo) * (H - 1));
+        };
+        fl_push_clip(X, Y, W, H);
+        for (std::size_t i = 0; i < series_.size(); i++) {
+            fl_color(series_[i].color);
+            if (n <= (std::size_t)W) {
+                auto end = std::min(last, series_[i].data.size());
+                fl_begin_line();
+                for (auto j = first; j < end; j++)
+                    fl_vertex(
+                        X + (double)(j - first) * (W - 1) /
+                                (double)std::max<std::size_t>(n - 1, 1),
+                        py(series_[i].data[j])
+                    );
+                fl_end_line();
+                continue;
+            }
+            int prev_top    = 0;
+            int prev_bottom = 0;
+            for (std::size_t c = 0; c < columns_[i].size(); c++) {
+                auto top    = py(columns_[i][c].second);
+                auto bottom = py(columns_[i][c].first);
+                // Join each column to the previous one so steps stay closed
+                if (c > 0) {
+                    top    = std::min(top, prev_bottom);
+                    bottom = std::max(bottom, prev_top);
+                }
+                fl_yxline(X + (int)c, top, bottom);
+                prev_top    = py(columns_[i][c].second);
+                prev_bottom = py(columns_[i][c].first);
+            }
+        }
+        fl_pop_clip();
+    }
+
+  public:
+    PlotDisplay(int x, int y, int w, int h, const char *label = nullptr)
+        : Fl_Box(x, y, w, h, label) {
+        box(FL_DOWN_BOX);
+        color(FL_BACKGROUND2_COLOR);
+    }
+    int handle(int event) override {
+        auto [first, last] = range();
+        auto n             = last - first;
+        switch (event) {
+        case FL_MOUSEWHEEL: {
+            auto total = (double)samples();
+            // Nothing to zoom, and clamping the span to [2, total] needs
+            // at least two samples
+            if (n == 0 || total < 2)
+                return 1;
+            auto frac  = (Fl::event_x() - x()) / (double)std::max(w(), 1);
+            frac       = std::clamp(frac, 0.0, 1.0);
+            auto scale = Fl::event_dy() > 0 ? 1.25 : 0.8;
+            auto span  = std::clamp((double)n * scale, 2.0, total);
+            auto start = (double)first + frac * ((double)n - span);
+            start      = std::clamp(start, 0.0, total - span);
+            xrange((std::size_t)start, (std::size_t)(start + span));
+            return 1;
+        }
+        case FL_PUSH:
+            if (Fl::event_clicks()) {
+                xrange(0, 0);
+                return 1;
+            }
+            drag_x_     = Fl::event_x();
+            drag_first_ = first;
+            return 1;
+        case FL_DRAG: {
+            if (n == 0 || w() <= 0)
+                return 1;
+            auto shift = (double)(drag_x_ - Fl::event_x()) * n / w();
+            auto start = std::clamp(
+                (double)drag_first_ + shift, 0.0, (double)(samples() - n)
+            );
+            xrange((std::size_t)start, (std::size_t)start + n);
+            return 1;
+        }
+        case FL_RELEASE:
+            return 1;
+        default:
+            return Fl_Box::handle(event);
+        }
+    }
+    /// Set the series to draw
+    void series(const std::vector<PlotSeries> &series) {
+        series_ = series;
+        pyramids_.resize(series_.size());
+        for (std::size_t i = 0; i < series_.size(); i++)
+            pyramids_[i].reset(series_[i].data, revision_);
+        redraw();
+    }
+    /// Mark the samples as modified in place, rebuilding the cached levels
+    void revision(std::uint64_t revision) {
+        revision_ = revision;
+        for (std::size_t i = 0; i < series_.size(); i++)
+            pyramids_[i].reset(series_[i].data, revision_);
+        redraw();
+    }
+    /// Show samples [first, last), or all of them if last is 0
+    void xrange(std::size_t first, std::size_t last) {
+        first_ = first;
+        last_  = last;
+        redraw();
+    }
+    /// Fix the value range, or fit it to the visible data if lo == hi
+    void yrange(double lo, double hi) {
+        yauto_ = !(hi > lo);
+        ymin_  = lo;
+        ymax_  = hi;
+        redraw();
+    }
+};
+
+template <class B>
+struct PlotProps {
+    std::vector<PlotSeries> series;
+    std::uint64_t revision = 0;
+    std::optional<std::pair<std::size_t, std::size_t>> xrange;
+    std::optional<std::pair<double, double>> yrange;
+    void view(B *w) {
+        w->revision(revision);
+        w->series(series);
+        if (xrange)
+            w->xrange(xrange->first, xrange->second);
+        if (yrange)
+            w->yrange(yrange->first, yrange->second);
+    }
+    void update(B *w, const PlotProps &other) {
+        if (*this == other)
+            return;
+        if (other.revision != revision) {
+            revision = other.revision;
+            w->revision(revision);
+        }
+        if (other.series != series) {
+            series = other.series;
+            w->series(series);
+        }
+        if (other.xrange != xrange) {
+            xrange = other.xrange;
+            auto [first, last] =
+                xrange ? *xrange : std::pair<std::size_t, std::size_t>();
+            w->xrange(first, last);
+        }
+        if (other.yrange != yrange) {
+            yrange = other.yrange;
+            auto [lo, hi] = yrange ? *yrange : std::pair(0.0, 0.0);
+            w->yrange(lo, hi);
+        }
+    }
+    bool operator==(const PlotProps &) const = default;
+    void hash(Hasher &h) const { h(series, revision, xrange, yrange); }
+};
+
+template <class Message, class W, class B>
+class PlotBase : public WidgetBase<Message, W, B> {
+  protected:
+    PlotProps<B> pprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        pprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               pprops == other.pprops;
+    }
+
+  public:
+    std::shared_ptr<Widget<Message>> create() override {
+        return std::shared_ptr<Widget<Message>>(new W(*(W *)this));
+    }
+    Fl_Widget *view() override {
+        WidgetBase<Message, W, B>::view();
+        this->pprops.view(this->inner);
+        return this->inner;
+    }
+    void update(Widget<Message> *other) override {
+        auto f = (W *)other;
+        WidgetBase<Message, W, B>::update(other);
+        this->pprops.update(this->inner, f->pprops);
+    }
+    virtual ~PlotBase() = default;
+
+    /// Add a series; the samples are not copied
+    W &series(std::span<const double> data, Color col = Color::Blue) {
+        pprops.series.push_back(PlotSeries{data, col});
+        return *(W *)this;
+    }
+    /// Bump when samples were modified in place
+    W &revision(std::uint64_t revision) {
+        pprops.revision = revision;
+        return *(W *)this;
+    }
+    /// Show samples [first, last)
+    W &xrange(std::size_t first, std::size_t last) {
+        pprops.xrange = std::make_pair(first, last);
+        return *(W *)this;
+    }
+    /// Fix the value range instead of fitting the visible data
+    W &yrange(double lo, double hi) {
+        pprops.yrange = std::make_pair(lo, hi);
+        return *(W *)this;
+    }
+};
+
+#define PLOT(Class, Base)                                                      \
+    template <class Message>                                                   \
+    class Class : public PlotBase<Message, Class<Message>, Base> {};
+
+PLOT(Plot, PlotDisplay)
+} // namespace detail
+} // namespace rf
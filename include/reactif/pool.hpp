@@ -0,0 +1,128 @@
+#pragma once
+
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rf::detail {
+
+/// A fixed set of worker threads shared by the widgets that do background
+/// work. Tasks must not touch FLTK; results are handed back to the UI thread
+/// by the caller.
+class ThreadPool {
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+    std::vector<std::jthread> workers_;
+
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            REACTIF_TRACE_SCOPE("task");
+            task();
+        }
+    }
+
+  public:
+    explicit ThreadPool(
+        unsigned threads = std::max(2U, std::thread::hardware_concurrency())
+    ) {
+        for (unsigned i = 0; i < threads; i++)
+            workers_.emplace_back([this] { work(); });
+    }
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+    }
+    [[nodiscard]] std::size_t size() const { return workers_.size(); }
+    /// Queue a task
+    void submit(std::function<void()> &&task) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+    /// The process-wide pool
+    static ThreadPool &global() {
+        static ThreadPool pool;
+        return pool;
+    }
+};
+
+/// A set of tasks that can be waited on together.
+/// wait() runs the group's own queued tasks while it waits, and only those,
+/// so groups may be nested inside pool tasks without starving the pool or
+/// picking up unrelated work.
+class TaskGroup {
+    /// Shared with the pool, which may run a task after wait() took it
+    struct State {
+        std::mutex mtx;
+        std::condition_variable done;
+        std::deque<std::function<void()>> tasks;
+        std::size_t pending = 0;
+
+        /// Run one of the group's queued tasks, if any are left
+        bool run_one() {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (tasks.empty())
+                    return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+            std::lock_guard<std::mutex> lock(mtx);
+            if (--pending == 0)
+                done.notify_all();
+            return true;
+        }
+    };
+    ThreadPool &pool_;
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+
+  public:
+    explicit TaskGroup(ThreadPool &pool = ThreadPool::global()) : pool_(pool) {}
+    TaskGroup(const TaskGroup &)            = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+    ~TaskGroup() { wait(); }
+    void run(std::function<void()> &&task) {
+        {
+            std::lock_guard<std::mutex> lock(state_->mtx);
+            state_->tasks.push_back(std::move(task));
+            state_->pending++;
+        }
+        pool_.submit([state = state_] { state->run_one(); });
+    }
+    /// Run the group's queued tasks, then block until those taken by the
+    /// pool finish
+    void wait() {
+        while (state_->run_one()) {
+        }
+        std::unique_lock<std::mutex> lock(state_->mtx);
+        state_->done.wait(lock, [this] { return state_->pending == 0; });
+    }
+};
+} // namespace rf::detail
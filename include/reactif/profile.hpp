@@ -0,0 +1,103 @@
+#pragma once
+
+#include "stats.hpp"
+#include <atomic>
+#include <cstddef>
+
+#if defined(REACTIF_PROFILE) && defined(REACTIF_PROFILE_HOOKS)
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace rf {
+
+/// The part of a frame that heap allocations are counted against
+enum class ProfilePhase {
+    /// Event handling, drawing, and work on other threads
+    Other,
+    Update,
+    View,
+    Diff,
+};
+
+namespace detail {
+
+/// Allocation and lifetime counters, bumped from any thread
+struct ProfileCounters {
+    std::atomic<std::size_t> allocs[4]    = {};
+    std::atomic<std::size_t> bytes[4]     = {};
+    std::atomic<std::size_t> live_nodes   = 0;
+    std::atomic<std::size_t> live_widgets = 0;
+};
+
+inline ProfileCounters &profile_counters() {
+    static ProfileCounters counters;
+    return counters;
+}
+
+/// The phase the calling thread's allocations are counted against
+inline ProfilePhase &profile_phase() {
+    thread_local ProfilePhase phase = ProfilePhase::Other;
+    return phase;
+}
+
+/// Counts the calling thread's allocations against a phase while in scope
+class PhaseScope {
+#ifdef REACTIF_PROFILE
+    ProfilePhase prev_;
+
+  public:
+    explicit PhaseScope(ProfilePhase p) : prev_(profile_phase()) {
+        profile_phase() = p;
+    }
+    ~PhaseScope() { profile_phase() = prev_; }
+#else
+  public:
+    explicit PhaseScope(ProfilePhase) {}
+#endif
+    PhaseScope(const PhaseScope &)            = delete;
+    PhaseScope &operator=(const PhaseScope &) = delete;
+};
+
+inline void count_alloc(std::size_t n) {
+    auto &c = profile_counters();
+    auto i  = (std::size_t)profile_phase();
+    c.allocs[i].fetch_add(1, std::memory_order_relaxed);
+    c.bytes[i].fetch_add(n, std::memory_order_relaxed);
+}
+
+/// Move the counters of the frame that ended into stats
+inline void profile_frame([[maybe_unused]] FrameStats &stats) {
+#ifdef REACTIF_PROFILE
+    auto &c   = profile_counters();
+    auto take = [&](ProfilePhase p) {
+        auto i = (std::size_t)p;
+        return AllocCount{c.allocs[i].exchange(0), c.bytes[i].exchange(0)};
+    };
+    stats.update_allocs = take(ProfilePhase::Update);
+    stats.view_allocs   = take(ProfilePhase::View);
+    stats.diff_allocs   = take(ProfilePhase::Diff);
+    stats.other_allocs  = take(ProfilePhase::Other);
+    stats.live_nodes    = c.live_nodes.load();
+    stats.live_widgets  = c.live_widgets.load();
+#endif
+}
+} // namespace detail
+} // namespace rf
+
+// Replacing the global allocator has to happen in exactly one translation
+// unit, which defines REACTIF_PROFILE_HOOKS before including reactif.
+// Over-aligned allocations are left uncounted.
+#if defined(REACTIF_PROFILE) && defined(REACTIF_PROFILE_HOOKS)
+void *operator new(std::size_t n) {
+    rf::detail::count_alloc(n);
+    if (auto *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#endif
@@ -1,17 +1,42 @@
 #pragma once
 
+#include "changed.hpp"
+#include "diff.hpp"
+#include "handler.hpp"
+#include "persistent.hpp"
+#include "replay.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include "widgets.hpp"
 #include <FL/Enumerations.H>
 #include <FL/Fl.H>
 #include <FL/Fl_Double_Window.H>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #define TRIGGER(x) [=, this] { return x; }
 
 namespace rf {
 
+/// How windows lay out their views while the user drags their edges
+enum class LiveResize {
+    /// Lay out the whole view on every resize event
+    Off,
+    /// Lay out the whole view at a reduced rate, and only the top-level
+    /// containers in between
+    Throttled,
+    /// Lay out only the top-level containers until resizing settles
+    TopLevelOnly,
+};
+
 struct Settings {
     /// The main window's position
     std::pair<int, int> pos = std::pair(0, 0);
@@ -48,12 +73,303 @@ struct Settings {
     std::optional<Scheme> scheme;
     /// Set the window's size range
     std::optional<std::tuple<int, int, int, int>> size_range;
+    /// Register box and label types only when first used, and show the
+    /// application's skeleton() while its full view is built
+    bool lazy_init = false;
+    /// Record every dispatched message to this file, encoded by the
+    /// application's codec()
+    std::optional<std::string> record_path;
+    /// Instead of waiting for events, feed this recorded log through the
+    /// application and pass the results to on_replay()
+    std::optional<std::string> replay_path;
+    ReplayMode replay_mode = ReplayMode::Fast;
+    /// Compare sibling subtrees on the thread pool when diffing a view,
+    /// applying the resulting patches in order on the UI thread
+    bool parallel_diff = false;
+    /// Put off laying out nested containers while a window is being
+    /// resized, doing one full layout once resizing settles
+    LiveResize live_resize = LiveResize::Off;
+    /// Record spans of message handling, view building, diffing and
+    /// drawing to this file, in the Chrome trace-event format
+    std::optional<std::string> trace_path;
+    /// Time the drawing of every widget, see Application::draw_profile()
+    bool profile_draws = false;
+};
+
+/// A secondary window, identified by its key across calls to windows()
+template <class Message>
+struct WindowSpec {
+    std::string key;
+    std::string title;
+    std::pair<int, int> size = std::pair(400, 300); // NOLINT
+    std::optional<std::pair<int, int>> pos;
+    /// Changed by the application whenever the window's view inputs change;
+    /// without one the window is diffed after every message
+    std::optional<std::uint64_t> revision;
+    /// The state regions the window's view reads; it is only rebuilt after
+    /// messages changing one of them
+    Changed reads = Changed::All;
+    /// Build the window's view
+    std::function<std::shared_ptr<Widget<Message>>()> view;
+    /// Sent when the user closes the window, which is otherwise just hidden
+    Handler<Message> on_close;
 };
 
+namespace detail {
+
+/// The main window, which reports when it is first drawn
+class RootWindow : public Fl_Double_Window {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last_layout_;
+
+    static void settle_cb(void *data) {
+        auto *self = (RootWindow *)data;
+        // Resizing to the same size has every container that deferred its
+        // layout catch up
+        self->Fl_Group::resize(self->x(), self->y(), self->w(), self->h());
+        self->redraw();
+    }
+
+  public:
+    /// Full layouts per second while LiveResize::Throttled
+    static constexpr double throttled_rate = 15;
+    /// How long after the last resize event resizing counts as settled
+    static constexpr double settle_secs = 0.15;
+    std::function<void()> on_drawn;
+    LiveResize live_resize = LiveResize::Off;
+    RootWindow(int x, int y, int w, int h) : Fl_Double_Window(x, y, w, h) {}
+    ~RootWindow() { Fl::remove_timeout(settle_cb, this); }
+    void resize(int x, int y, int w, int h) override {
+        if (w == this->w() && h == this->h()) {
+            Fl_Double_Window::resize(x, y, w, h);
+            return;
+        }
+        frame_stats().resize_events++;
+        if (live_resize == LiveResize::Off || !shown()) {
+            Fl_Double_Window::resize(x, y, w, h);
+            return;
+        }
+        auto now      = Clock::now();
+        auto interval = std::chrono::duration<double>(1 / throttled_rate);
+        auto full     = live_resize == LiveResize::Throttled &&
+                        now - last_layout_ >= interval;
+        if (full)
+            last_layout_ = now;
+        deferring_layout() = !full;
+        Fl_Double_Window::resize(x, y, w, h);
+        deferring_layout() = false;
+        Fl::remove_timeout(settle_cb, this);
+        Fl::add_timeout(settle_secs, settle_cb, this);
+    }
+
+  protected:
+    void draw() override {
+        REACTIF_TRACE_SCOPE("draw");
+        Fl_Double_Window::draw();
+        if (on_drawn) {
+            auto f   = std::move(on_drawn);
+            on_drawn = nullptr;
+            f();
+        }
+    }
+};
+} // namespace detail
+
 /// The default Application object
 template <class Message>
 class Application : public detail::DefaultWidgets<Message> {
-    Settings settings_ = {};
+    struct Mounted {
+        detail::RootWindow *win = nullptr;
+        std::shared_ptr<Widget<Message>> widget;
+        std::string title;
+        std::optional<std::uint64_t> revision;
+        Handler<Message> on_close;
+    };
+    using Clock = std::chrono::steady_clock;
+    Settings settings_                      = {};
+    StartupTrace trace_                     = {};
+    std::map<std::string, Mounted> windows_ = {};
+    detail::RootWindow *win_                = nullptr;
+    std::shared_ptr<Widget<Message>> root_;
+    std::optional<std::uint64_t> revision_;
+    std::optional<MessageCodec<Message>> codec_;
+    std::unique_ptr<detail::MessageLogWriter> recorder_;
+    Clock::time_point record_start_;
+    std::string encoded_;
+    Changed changed_ = Changed::All;
+
+    static void close_cb(Fl_Widget *w, void *data) {
+        auto *m = static_cast<Mounted *>(data);
+        if (m->on_close)
+            Fl::awake((void *)&m->on_close);
+        else
+            w->hide();
+    }
+    /// Make win show next, patching the current tree when the roots match
+    void reconcile(
+        Fl_Window *win,
+        std::shared_ptr<Widget<Message>> &current,
+        std::shared_ptr<Widget<Message>> next
+    ) {
+        REACTIF_TRACE_SCOPE("reconcile");
+        if (current && current == next) {
+            detail::frame_stats().reused_subtrees++;
+            return;
+        }
+        if (current && next && detail::patchable(current, next)) {
+            if (settings_.parallel_diff) {
+                using Diff = detail::TreeDiff<Message>;
+                Diff::apply(Diff::run(current.get(), next.get()));
+            } else if (detail::same_hash(*current, *next)) {
+                detail::frame_stats().skipped_subtrees++;
+            } else {
+                REACTIF_TRACE_SCOPE("patch");
+                current->update(next.get());
+            }
+            return;
+        }
+        REACTIF_TRACE_SCOPE("mount");
+        current = std::move(next);
+        win->clear();
+        if (current) {
+            win->begin();
+            auto *wid = current->view();
+            wid->resize(0, 0, win->w(), win->h());
+            if (settings_.resizable)
+                win->resizable(wid);
+            win->end();
+        }
+        win->redraw();
+    }
+    /// Create, update and destroy secondary windows to match windows().
+    /// Windows whose revision is unchanged are not rebuilt.
+    void sync_windows() {
+        REACTIF_TRACE_SCOPE("sync windows");
+        std::vector<WindowSpec<Message>> specs;
+        {
+            detail::PhaseScope phase(ProfilePhase::View);
+            specs = windows();
+        }
+        std::set<std::string> seen;
+        for (auto &spec : specs) {
+            seen.insert(spec.key);
+            auto [it, added] = windows_.try_emplace(spec.key);
+            auto &m          = it->second;
+            if (added) {
+                auto [w, h] = spec.size;
+                m.win       = new detail::RootWindow(0, 0, w, h); // NOLINT
+                m.win->live_resize = settings_.live_resize;
+                m.win->end();
+                if (spec.pos)
+                    m.win->position(spec.pos->first, spec.pos->second);
+                else
+                    m.win->free_position();
+                m.win->callback(close_cb, &m);
+            }
+            if (added || spec.title != m.title) {
+                m.title = spec.title;
+                m.win->copy_label(m.title.c_str());
+            }
+            m.on_close = std::move(spec.on_close);
+            if (!added && ((spec.revision && spec.revision == m.revision) ||
+                           !overlaps(changed_, spec.reads)))
+                continue;
+            m.revision = spec.revision;
+            std::shared_ptr<Widget<Message>> view;
+            if (spec.view) {
+                REACTIF_TRACE_SCOPE("view");
+                detail::PhaseScope phase(ProfilePhase::View);
+                view = spec.view();
+            }
+            {
+                detail::PhaseScope phase(ProfilePhase::Diff);
+                reconcile(m.win, m.widget, std::move(view));
+            }
+            if (added)
+                m.win->show();
+        }
+        for (auto it = windows_.begin(); it != windows_.end();) {
+            if (seen.count(it->first)) {
+                ++it;
+                continue;
+            }
+            Fl::delete_widget(it->second.win);
+            it = windows_.erase(it);
+        }
+    }
+
+    /// Handle msg and bring every window's view up to date
+    void dispatch(const Message &msg) {
+        REACTIF_TRACE_SCOPE("dispatch");
+        if (recorder_) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - record_start_
+            );
+            encoded_.clear();
+            codec_->encode(msg, encoded_);
+            recorder_->write((std::uint64_t)us.count(), encoded_);
+        }
+        {
+            REACTIF_TRACE_SCOPE("update");
+            detail::PhaseScope phase(ProfilePhase::Update);
+            changed_ = reduce(msg);
+        }
+        if (changed_ == Changed::None) {
+            detail::frame_stats().unchanged_messages++;
+            return;
+        }
+        auto next = view_revision();
+        if (!next || next != revision_) {
+            revision_ = next;
+            std::shared_ptr<Widget<Message>> root;
+            {
+                REACTIF_TRACE_SCOPE("view");
+                detail::PhaseScope phase(ProfilePhase::View);
+                root = view();
+            }
+            detail::PhaseScope phase(ProfilePhase::Diff);
+            reconcile(win_, root_, std::move(root));
+        }
+        sync_windows();
+    }
+    /// Dispatch the messages of a recorded log, timing each one up to the
+    /// end of its redraw
+    ReplayReport replay(const std::string &path, ReplayMode mode) {
+        ReplayReport report;
+        detail::MessageLogReader reader(path);
+        auto c = codec();
+        if (!reader.valid() || !c)
+            return report;
+        auto ms = [](Clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        };
+        auto start = Clock::now();
+        std::uint64_t us = 0;
+        std::string_view bytes;
+        while (reader.next(us, bytes)) {
+            if (mode == ReplayMode::RealTime) {
+                auto due = start + std::chrono::microseconds(us);
+                // Keep handling events while waiting for the next message
+                for (auto now = Clock::now(); now < due; now = Clock::now())
+                    Fl::wait(std::chrono::duration<double>(due - now).count());
+            }
+            auto msg = c->decode(bytes);
+            if (!msg) {
+                report.skipped++;
+                continue;
+            }
+            auto begin = Clock::now();
+            dispatch(*msg);
+            Fl::flush();
+            report.latencies_ms.push_back(ms(Clock::now() - begin));
+            report.messages++;
+            if (detail::tracing())
+                detail::Tracer::global().flush();
+        }
+        report.total_ms = ms(Clock::now() - start);
+        std::sort(report.latencies_ms.begin(), report.latencies_ms.end());
+        return report;
+    }
 
   public:
     Application(Settings &&settings) : settings_(std::move(settings)) {}
@@ -63,27 +379,83 @@ class Application : public detail::DefaultWidgets<Message> {
     /// Set the view of the application
     virtual std::shared_ptr<Widget<Message>> view() = 0;
     /// Handle updates
-    virtual void update(const Message &msg) = 0;
+    virtual void update(const Message &) {}
+    /// Handle msg and report which regions of state it changed. When it
+    /// changed none, view(), diffing and windows() are skipped. Calls
+    /// update() and reports everything changed unless overridden.
+    virtual Changed reduce(const Message &msg) {
+        update(msg);
+        return Changed::All;
+    }
+    /// The regions changed by the message being handled, for view() and
+    /// windows() to pass on to RegionMemo
+    [[nodiscard]] Changed changed() const { return changed_; }
+    /// Secondary windows, each with its own view
+    virtual std::vector<WindowSpec<Message>> windows() { return {}; }
+    /// Changed whenever the main view's inputs change. Without one the main
+    /// view is diffed after every message.
+    [[nodiscard]] virtual std::optional<std::uint64_t> view_revision() const {
+        return std::nullopt;
+    }
+    /// Called once per event loop iteration with the counters of the
+    /// previous one
+    virtual void on_frame(const FrameStats &) {}
+    /// The counters of the current event loop iteration
+    [[nodiscard]] const FrameStats &frame_stats() const {
+        return detail::frame_stats();
+    }
+    /// What drawing each widget has cost since the last reset, gathered
+    /// when Settings::profile_draws is set
+    [[nodiscard]] DrawProfile draw_profile() const {
+        return detail::DrawProfiler::global().snapshot();
+    }
+    /// Start gathering the draw profile afresh
+    void reset_draw_profile() { detail::DrawProfiler::global().reset(); }
+    /// A cheap view shown first when Settings::lazy_init is set
+    virtual std::shared_ptr<Widget<Message>> skeleton() { return nullptr; }
+    /// Called once the full view has been drawn for the first time
+    virtual void on_startup(const StartupTrace &) {}
+    /// Timings of the application's startup
+    [[nodiscard]] const StartupTrace &startup_trace() const { return trace_; }
+    /// Serializes messages for Settings::record_path and replay_path
+    virtual std::optional<MessageCodec<Message>> codec() const {
+        return std::nullopt;
+    }
+    /// Called with the results once Settings::replay_path was replayed,
+    /// after which run() returns
+    virtual void on_replay(const ReplayReport &) {}
     /// Run the application
     void run(int argc, char **argv) {
-        fl_define_FL_ROUND_UP_BOX();
-        fl_define_FL_SHADOW_BOX();
-        fl_define_FL_ROUNDED_BOX();
-        fl_define_FL_RFLAT_BOX();
-        fl_define_FL_RSHADOW_BOX();
-        fl_define_FL_DIAMOND_BOX();
-        fl_define_FL_OVAL_BOX();
-        fl_define_FL_PLASTIC_UP_BOX();
-        fl_define_FL_GTK_UP_BOX();
-        fl_define_FL_GLEAM_UP_BOX();
-        fl_define_FL_SHADOW_LABEL();
-        fl_define_FL_ENGRAVED_LABEL();
-        fl_define_FL_EMBOSSED_LABEL();
-        fl_define_FL_MULTI_LABEL();
-        fl_define_FL_ICON_LABEL();
-        fl_define_FL_IMAGE_LABEL();
+        detail::StartupClock clock;
+        trace_ = {};
+        if (settings_.trace_path)
+            detail::Tracer::global().open(*settings_.trace_path);
+        detail::DrawProfiler::global().enable(settings_.profile_draws);
+        if (!settings_.lazy_init) {
+            fl_define_FL_ROUND_UP_BOX();
+            fl_define_FL_SHADOW_BOX();
+            fl_define_FL_ROUNDED_BOX();
+            fl_define_FL_RFLAT_BOX();
+            fl_define_FL_RSHADOW_BOX();
+            fl_define_FL_DIAMOND_BOX();
+            fl_define_FL_OVAL_BOX();
+            fl_define_FL_PLASTIC_UP_BOX();
+            fl_define_FL_GTK_UP_BOX();
+            fl_define_FL_GLEAM_UP_BOX();
+            fl_define_FL_SHADOW_LABEL();
+            fl_define_FL_ENGRAVED_LABEL();
+            fl_define_FL_EMBOSSED_LABEL();
+            fl_define_FL_MULTI_LABEL();
+            fl_define_FL_ICON_LABEL();
+            fl_define_FL_IMAGE_LABEL();
+            clock.mark(trace_, "define types");
+        }
         Fl::use_high_res_GL(1);
-        auto widget = view();
+        auto widget = settings_.lazy_init ? skeleton() : nullptr;
+        bool skeleton_first = widget != nullptr;
+        if (!skeleton_first)
+            widget = view();
+        clock.mark(trace_, skeleton_first ? "skeleton" : "view");
         if (settings_.scheme)
             Fl::scheme(settings_.scheme->c_str());
         else
@@ -110,9 +482,12 @@ class Application : public detail::DefaultWidgets<Message> {
         }
         if (settings_.visible_focus)
             Fl::visible_focus(*settings_.visible_focus);
+        clock.mark(trace_, "settings");
         auto [x, y] = settings_.pos;
         auto [w, h] = settings_.size;
-        auto *win   = new Fl_Double_Window(x, y, w, h); // NOLINT
+        auto *win   = new detail::RootWindow(x, y, w, h); // NOLINT
+        win_        = win;
+        win->live_resize = settings_.live_resize;
         if (!settings_.force_position)
             win->free_position();
         win->copy_label(title().c_str());
@@ -121,48 +496,74 @@ class Application : public detail::DefaultWidgets<Message> {
             FL_NORMAL_SIZE = settings_.font_size;
         if (settings_.font)
             Fl::set_font(FL_HELVETICA, *settings_.font);
-        if (widget) {
-            auto *wid = widget->view();
-            wid->resize(0, 0, w, h);
-            if (settings_.resizable)
-                win->resizable(wid);
-        }
         win->end();
+        root_ = nullptr;
+        reconcile(win, root_, std::move(widget));
+        clock.mark(trace_, "create widgets");
         if (settings_.size_range) {
             auto [x, y, w, h] = *settings_.size_range;
             win->size_range(x, y, w, h);
         }
+        auto first_frame = [&, this] {
+            trace_.first_frame_ms = clock.elapsed();
+            on_startup(trace_);
+        };
+        if (!skeleton_first)
+            win->on_drawn = first_frame;
         win->show(argc, argv);
+        trace_.window_shown_ms = clock.elapsed();
+        clock.mark(trace_, "show");
+        if (skeleton_first) {
+            // Put the skeleton on screen before building the real view
+            Fl::check();
+            widget = view();
+            clock.mark(trace_, "view");
+            reconcile(win, root_, std::move(widget));
+            win->on_drawn = first_frame;
+            // The patch may have been skipped or may not have damaged the
+            // window, and the first frame is only reported once it is drawn
+            win->redraw();
+            clock.mark(trace_, "create widgets");
+        }
         if (settings_.ignore_esc_close) {
             win->callback([](Fl_Widget *w) {
                 if (Fl::event() == FL_CLOSE)
                     w->hide();
             });
         }
+        revision_ = view_revision();
+        sync_windows();
+        if (settings_.replay_path) {
+            on_replay(replay(*settings_.replay_path, settings_.replay_mode));
+            detail::Tracer::global().close();
+            return;
+        }
+        codec_ = settings_.record_path ? codec() : std::nullopt;
+        if (codec_) {
+            recorder_ = std::make_unique<detail::MessageLogWriter>(
+                *settings_.record_path
+            );
+            if (!recorder_->valid())
+                recorder_ = nullptr;
+            record_start_ = Clock::now();
+        }
         Fl::lock();
         while (Fl::wait()) {
+            detail::profile_frame(detail::frame_stats());
+            on_frame(detail::frame_stats());
+            detail::frame_stats().reset();
+            if (detail::tracing())
+                detail::Tracer::global().flush();
             auto msg = Fl::thread_message();
             if (msg) {
-                auto msg1 = *static_cast<std::function<Message()> *>(msg);
-                update(msg1());
-                auto widget2 = view();
-                if (widget && widget2) {
-                    if (typeid(*widget) == typeid(*widget2))
-                        widget->update(widget2.get());
-                    else {
-                        widget = widget2;
-                        win->clear();
-                        win->begin();
-                        auto *wid = widget->view();
-                        wid->resize(0, 0, w, h);
-                        if (settings_.resizable)
-                            win->resizable(wid);
-                        win->end();
-                        win->redraw();
-                    }
-                }
+                // Evaluated right away, before dispatch() can replace the
+                // node that owns the closure
+                auto *handler = static_cast<Handler<Message> *>(msg);
+                dispatch((*handler)());
             }
         }
+        recorder_ = nullptr;
+        detail::Tracer::global().close();
     }
 };
 } // namespace rf
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rf {
+
+/// Turns messages into bytes and back, for recording and replaying them
+template <class Message>
+struct MessageCodec {
+    std::function<void(const Message &, std::string &out)> encode;
+    std::function<std::optional<Message>(std::string_view)> decode;
+};
+
+enum class ReplayMode {
+    /// Dispatch each message as soon as the previous frame is flushed
+    Fast,
+    /// Keep the recorded gaps between messages
+    RealTime,
+};
+
+/// How a replayed message log performed
+struct ReplayReport {
+    std::size_t messages = 0;
+    /// Records the codec could not decode
+    std::size_t skipped = 0;
+    /// From the first message until the last frame was flushed
+    double total_ms = 0;
+    /// Time spent on each message's update, view, diff and redraw, sorted
+    std::vector<double> latencies_ms;
+
+    /// Messages per second, counting only the time spent on them
+    [[nodiscard]] double throughput() const {
+        double busy = 0;
+        for (auto ms : latencies_ms)
+            busy += ms;
+        return busy > 0 ? (double)messages * 1000 / busy : 0;
+    }
+    /// The latency below which p percent of messages were handled
+    [[nodiscard]] double percentile(double p) const {
+        if (latencies_ms.empty())
+            return 0;
+        auto n    = latencies_ms.size();
+        auto rank = (std::size_t)std::ceil(p / 100 * (double)n);
+        return latencies_ms[std::clamp<std::size_t>(rank, 1, n) - 1];
+    }
+    [[nodiscard]] std::string report() const {
+        char buf[256];
+        std::snprintf(
+            buf,
+            sizeof(buf),
+            "%zu messages (%zu skipped) in %.2f ms, %.0f msg/s\n"
+            "latency p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            messages,
+            skipped,
+            total_ms,
+            throughput(),
+            percentile(50),
+            percentile(90),
+            percentile(99),
+            percentile(100)
+        );
+        return buf;
+    }
+};
+
+namespace detail {
+
+/// Writes a message log: a magic line, then one record per message made of
+/// the microseconds since the previous one and the encoded length, both as
+/// LEB128 varints, followed by the encoded bytes
+class MessageLogWriter {
+    std::FILE *file_ = nullptr;
+    std::string buf_;
+    std::uint64_t last_us_ = 0;
+
+    void varint(std::uint64_t v) {
+        while (v >= 0x80) {
+            buf_ += (char)(v | 0x80);
+            v >>= 7;
+        }
+        buf_ += (char)v;
+    }
+
+  public:
+    static constexpr std::string_view magic = "reactif-log-1\n";
+    explicit MessageLogWriter(const std::string &path)
+        : file_(std::fopen(path.c_str(), "wb")) {
+        buf_ = magic;
+    }
+    MessageLogWriter(const MessageLogWriter &)            = delete;
+    MessageLogWriter &operator=(const MessageLogWriter &) = delete;
+    ~MessageLogWriter() {
+        flush();
+        if (file_)
+            std::fclose(file_);
+    }
+    [[nodiscard]] bool valid() const { return file_ != nullptr; }
+    /// Append a message sent us microseconds after recording started
+    void write(std::uint64_t us, std::string_view bytes) {
+        varint(us - std::min(us, last_us_));
+        varint(bytes.size());
+        buf_ += bytes;
+        last_us_ = us;
+        if (buf_.size() >= (std::size_t(64) << 10))
+            flush();
+    }
+    void flush() {
+        if (file_ && !buf_.empty())
+            std::fwrite(buf_.data(), 1, buf_.size(), file_);
+        buf_.clear();
+    }
+};
+
+/// Reads back the records of a MessageLogWriter
+class MessageLogReader {
+    MappedFile file_;
+    std::size_t pos_  = 0;
+    std::uint64_t us_ = 0;
+
+    bool varint(std::uint64_t &v) {
+        v = 0;
+        for (unsigned shift = 0; pos_ < file_.size() && shift < 64;
+             shift += 7) {
+            auto byte = (unsigned char)file_.data()[pos_++];
+            v |= (std::uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+  public:
+    explicit MessageLogReader(const std::string &path) : file_(path) {
+        if (valid())
+            pos_ = MessageLogWriter::magic.size();
+    }
+    /// Whether the file exists and is a message log
+    [[nodiscard]] bool valid() const {
+        return file_.valid() &&
+               file_.view().starts_with(MessageLogWriter::magic);
+    }
+    /// The next record, with its time since recording started, or false at
+    /// the end of the log
+    bool next(std::uint64_t &us, std::string_view &bytes) {
+        std::uint64_t delta = 0;
+        std::uint64_t len   = 0;
+        if (!valid() || !varint(delta) || !varint(len) ||
+            len > file_.size() - pos_)
+            return false;
+        us_ += delta;
+        pos_ += len;
+        us    = us_;
+        bytes = file_.view().substr(pos_ - len, len);
+        return true;
+    }
+};
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace rf {
+
+/// Heap allocations made during one part of a frame
+struct AllocCount {
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+};
+
+/// Counters gathered during one iteration of the event loop, which covers
+/// handling a message, reconciling the view and the redraw that follows
+struct FrameStats {
+    /// Flex layouts served from the cached child rectangles
+    std::size_t layout_hits = 0;
+    /// Flex layouts that had to be computed
+    std::size_t layout_misses = 0;
+    /// Subtrees left alone by the reconciler because their structural hash
+    /// matched the mounted one
+    std::size_t skipped_subtrees = 0;
+    /// Subtrees left alone because the view handed back the mounted node
+    /// itself, as a ChunkMemo or RegionMemo does for unchanged parts
+    std::size_t reused_subtrees = 0;
+    /// Subtrees mounted afresh instead of patched, because the mounted or
+    /// the new node was also held elsewhere, see detail::patchable()
+    std::size_t remounted_subtrees = 0;
+    /// Messages whose reduce() changed nothing, so no view was built
+    std::size_t unchanged_messages = 0;
+    /// Window resize events that changed a window's size
+    std::size_t resize_events = 0;
+    /// Containers laid out after being resized
+    std::size_t relayouts = 0;
+    /// Container layouts put off during a live resize
+    std::size_t deferred_relayouts = 0;
+    /// Allocations made by update(), by building views, by diffing them
+    /// and by everything else. Only counted in REACTIF_PROFILE builds that
+    /// install the allocator hooks.
+    AllocCount update_allocs;
+    AllocCount view_allocs;
+    AllocCount diff_allocs;
+    AllocCount other_allocs;
+    /// Virtual nodes and FLTK widgets alive at the end of the frame. Only
+    /// counted in REACTIF_PROFILE builds.
+    std::size_t live_nodes   = 0;
+    std::size_t live_widgets = 0;
+
+    [[nodiscard]] double layout_hit_rate() const {
+        auto total = layout_hits + layout_misses;
+        return total ? (double)layout_hits / (double)total : 1.0;
+    }
+    void reset() { *this = FrameStats{}; }
+};
+
+/// Where the time went while an application started
+struct StartupTrace {
+    struct Phase {
+        const char *name;
+        double ms;
+    };
+    /// Init phases in the order they ran
+    std::vector<Phase> phases;
+    /// From entering run() until the window was shown
+    double window_shown_ms = 0;
+    /// From entering run() until the full view was first drawn
+    double first_frame_ms = 0;
+
+    /// One line per phase, followed by the two totals
+    [[nodiscard]] std::string report() const {
+        std::string out;
+        auto line = [&out](const char *name, double ms) {
+            char buf[128];
+            std::snprintf(buf, sizeof(buf), "%-20s %9.2f ms\n", name, ms);
+            out += buf;
+        };
+        for (const auto &p : phases)
+            line(p.name, p.ms);
+        line("window shown", window_shown_ms);
+        line("first frame", first_frame_ms);
+        return out;
+    }
+};
+
+namespace detail {
+
+/// Records StartupTrace phases as the time since the previous mark
+class StartupClock {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start_ = Clock::now();
+    Clock::time_point last_  = start_;
+
+    static double ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+  public:
+    void mark(StartupTrace &trace, const char *phase) {
+        auto now = Clock::now();
+        trace.phases.push_back({phase, ms(now - last_)});
+        last_ = now;
+    }
+    [[nodiscard]] double elapsed() const { return ms(Clock::now() - start_); }
+};
+
+/// The counters of the current frame, only touched on the UI thread
+inline FrameStats &frame_stats() {
+    static FrameStats stats;
+    return stats;
+}
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,580 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "pool.hpp"
+#include "widget.hpp"
+#include <FL/Fl.H>
+#include <FL/Fl_Table_Row.H>
+#include <FL/fl_draw.H>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace rf {
+
+/// Column-oriented data displayed by table().
+/// Cells are formatted on demand while drawing, so nothing is copied into
+/// the widget. Implementations must be safe to read from worker threads,
+/// which compute sorting and filtering.
+class TableSource {
+  public:
+    /// A cell's sort key: numeric cells sort before text ones
+    struct Key {
+        double num = 0;
+        std::string_view text;
+        bool numeric = false;
+        bool operator<(const Key &other) const {
+            if (numeric != other.numeric)
+                return numeric;
+            return numeric ? num < other.num : text < other.text;
+        }
+    };
+    virtual ~TableSource() = default;
+    [[nodiscard]] virtual std::size_t rows() const = 0;
+    [[nodiscard]] virtual std::size_t cols() const = 0;
+    [[nodiscard]] virtual std::string_view header(std::size_t col) const = 0;
+    /// Text of a cell; buf may be used as scratch space for formatting
+    [[nodiscard]] virtual std::string_view
+    cell(std::size_t row, std::size_t col, std::span<char> buf) const = 0;
+    /// The key used to sort by a column. The text must stay valid for as
+    /// long as the source does.
+    [[nodiscard]] virtual Key key(std::size_t row, std::size_t col) const = 0;
+    /// Whether rows are still being added, e.g. while a file is indexed
+    [[nodiscard]] virtual bool loading() const { return false; }
+};
+
+/// A table held as typed column vectors
+class ColumnTable : public TableSource {
+    using Column = std::variant<
+        std::vector<std::int64_t>,
+        std::vector<double>,
+        std::vector<std::string>>;
+    std::vector<std::string> headers_;
+    std::vector<Column> columns_;
+    std::size_t rows_ = 0;
+
+  public:
+    /// Add a column; all columns should have the same length
+    template <class T>
+    ColumnTable &add(std::string_view header, std::vector<T> &&data) {
+        rows_ = columns_.empty() ? data.size() : std::min(rows_, data.size());
+        headers_.emplace_back(header);
+        columns_.emplace_back(std::move(data));
+        return *this;
+    }
+    [[nodiscard]] std::size_t rows() const override { return rows_; }
+    [[nodiscard]] std::size_t cols() const override { return columns_.size(); }
+    [[nodiscard]] std::string_view header(std::size_t col) const override {
+        return headers_[col];
+    }
+    [[nodiscard]] std::string_view
+    cell(std::size_t row, std::size_t col, std::span<char> buf) const override {
+        return std::visit(
+            [&](const auto &c) -> std::string_view {
+                using T = typename std::decay_t<decltype(c)>::value_type;
+                if constexpr (std::is_same_v<T, std::string>) {
+                    return c[row];
+                } else if constexpr (std::is_same_v<T, double>) {
+                    auto n =
+                        std::snprintf(buf.data(), buf.size(), "%g", c[row]);
+                    return {buf.data(), (std::size_t)std::max(n, 0)};
+                } else {
+                    auto r = std::to_chars(
+                        buf.data(), buf.data() + buf.size(), c[row]
+                    );
+                    return {buf.data(), (std::size_t)(r.ptr - buf.data())};
+                }
+            },
+            columns_[col]
+        );
+    }
+    [[nodiscard]] Key key(std::size_t row, std::size_t col) const override {
+        return std::visit(
+            [&](const auto &c) -> Key {
+                using T = typename std::decay_t<decltype(c)>::value_type;
+                if constexpr (std::is_same_v<T, std::string>)
+                    return {0, c[row], false};
+                else
+                    return {(double)c[row], {}, true};
+            },
+            columns_[col]
+        );
+    }
+};
+
+/// A memory-mapped CSV file with a row offset index built in the background.
+/// Cells are located by scanning the row when needed; simple double-quoted
+/// fields are supported.
+class CsvTable : public TableSource {
+    std::shared_ptr<const detail::MappedFile> file_;
+    std::unique_ptr<detail::LineIndex> index_;
+    std::vector<std::string> headers_;
+    char sep_;
+    bool has_header_;
+
+    [[nodiscard]] std::string_view field(std::string_view row, std::size_t col)
+        const {
+        std::size_t i = 0;
+        for (std::size_t c = 0;; c++) {
+            auto start  = i;
+            bool quoted = i < row.size() && row[i] == '"';
+            if (quoted) {
+                start = ++i;
+                while (i < row.size() &&
+                       !(row[i] == '"' &&
+                         (i + 1 == row.size() || row[i + 1] != '"')))
+                    i += row[i] == '"' ? 2 : 1;
+            }
+            auto end = row.find(sep_, i);
+            if (end == std::string_view::npos)
+                end = row.size();
+            if (c == col) {
+                auto stop = quoted ? std::min(i, row.size()) : end;
+                return row.substr(std::min(start, row.size()), stop - start);
+            }
+            if (end == row.size())
+                return {};
+            i = end + 1;
+        }
+    }
+    [[nodiscard]] std::string_view line(std::size_t row) const {
+        return index_ ? index_->line(row + (has_header_ ? 1 : 0))
+                      : std::string_view();
+    }
+
+  public:
+    explicit CsvTable(
+        const std::string &path, char sep = ',', bool has_header = true
+    )
+        : file_(std::make_shared<const detail::MappedFile>(path)), sep_(sep),
+          has_header_(has_header) {
+        if (!file_->valid())
+            return;
+        auto data  = file_->view();
+        auto first = data.substr(0, data.find('\n'));
+        if (!first.empty() && first.back() == '\r')
+            first.remove_suffix(1);
+        std::size_t n = std::count(first.begin(), first.end(), sep_) + 1;
+        for (std::size_t c = 0; c < n; c++)
+            headers_.emplace_back(
+                has_header_ ? field(first, c) : std::to_string(c + 1)
+            );
+        index_ = std::make_unique<detail::LineIndex>(file_, 1);
+    }
+    [[nodiscard]] std::size_t rows() const override {
+        auto n    = index_ ? index_->lines() : 0;
+        auto skip = has_header_ ? 1U : 0U;
+        return n > skip ? n - skip : 0;
+    }
+    [[nodiscard]] std::size_t cols() const override { return headers_.size(); }
+    [[nodiscard]] std::string_view header(std::size_t col) const override {
+        return headers_[col];
+    }
+    [[nodiscard]] std::string_view
+    cell(std::size_t row, std::size_t col, std::span<char>) const override {
+        return field(line(row), col);
+    }
+    [[nodiscard]] Key key(std::size_t row, std::size_t col) const override {
+        auto text       = field(line(row), col);
+        double num      = 0;
+        const auto *end = text.data() + text.size();
+        auto r          = std::from_chars(text.data(), end, num);
+        if (r.ec == std::errc() && r.ptr == end)
+            return {num, text, true};
+        return {0, text, false};
+    }
+    [[nodiscard]] bool loading() const override {
+        return index_ && !index_->done();
+    }
+};
+
+/// Filters the rows shown by a table, evaluated on worker threads
+using TableFilter = std::function<bool(const TableSource &, std::size_t row)>;
+
+namespace detail {
+
+/// An Fl_Table_Row drawing cells straight from a TableSource.
+/// Sorting and filtering run on the thread pool and produce a permutation
+/// of source rows; the displayed rows switch over once it is ready.
+class DataTable : public Fl_Table_Row {
+    struct Job {
+        std::atomic<bool> cancelled = false;
+        std::atomic<bool> ready     = false;
+        std::size_t seen            = 0;
+        std::vector<std::size_t> rows;
+    };
+
+    std::shared_ptr<TableSource> source_;
+    std::shared_ptr<const std::vector<std::size_t>> perm_;
+    std::shared_ptr<Job> job_;
+    int sort_col_  = -1;
+    bool sort_asc_ = true;
+    TableFilter filter_;
+
+    static constexpr double poll = 0.05;
+
+    static void poll_cb(void *data) {
+        auto *self = static_cast<DataTable *>(data);
+        if (self->job_ && self->job_->ready) {
+            auto seen   = self->job_->seen;
+            self->perm_ = std::make_shared<const std::vector<std::size_t>>(
+                std::move(self->job_->rows)
+            );
+            self->job_.reset();
+            // Rows loaded while the job ran are picked up by another pass
+            if (self->source_ && self->source_->rows() != seen)
+                self->recompute();
+        }
+        self->sync_rows();
+        if (self->job_ || (self->source_ && self->source_->loading()))
+            self->watch();
+    }
+    void watch() {
+        if (!Fl::has_timeout(poll_cb, this))
+            Fl::add_timeout(poll, poll_cb, this);
+    }
+    void sync_rows() {
+        auto n = perm_ ? perm_->size() : source_ ? source_->rows() : 0;
+        if ((std::size_t)rows() != n)
+            rows((int)std::min<std::size_t>(n, INT_MAX));
+        redraw();
+    }
+    static void compute(
+        const std::shared_ptr<Job> &job,
+        const std::shared_ptr<TableSource> &source,
+        const TableFilter &filter,
+        int col,
+        bool ascending
+    ) {
+        auto n    = source->rows();
+        job->seen = n;
+        using Entry = std::pair<TableSource::Key, std::size_t>;
+        std::vector<Entry> entries;
+        entries.reserve(n);
+        for (std::size_t r = 0; r < n; r++) {
+            if ((r & 0xffff) == 0 && job->cancelled)
+                return;
+            if (filter && !filter(*source, r))
+                continue;
+            entries.emplace_back(
+                col >= 0 ? source->key(r, col) : TableSource::Key{}, r
+            );
+        }
+        if (col >= 0) {
+            auto cmp = [ascending](const Entry &a, const Entry &b) {
+                if (a.first < b.first)
+                    return ascending;
+                if (b.first < a.first)
+                    return !ascending;
+                return a.second < b.second;
+            };
+            // Sort chunks in parallel, then merge them pairwise
+            auto &pool   = ThreadPool::global();
+            auto chunks  = std::max<std::size_t>(pool.size(), 1);
+            auto per     = (entries.size() + chunks - 1) / chunks;
+            std::vector<std::size_t> bounds;
+            for (std::size_t b = 0; b < entries.size(); b += per ? per : 1)
+                bounds.push_back(b);
+            bounds.push_back(entries.size());
+            {
+                TaskGroup group(pool);
+                for (std::size_t i = 0; i + 1 < bounds.size(); i++)
+                    group.run([&, i] {
+                        std::sort(
+                            entries.begin() + bounds[i],
+                            entries.begin() + bounds[i + 1],
+                            cmp
+                        );
+                    });
+            }
+            while (bounds.size() > 2 && !job->cancelled) {
+                std::vector<std::size_t> merged;
+                for (std::size_t i = 0; i + 2 < bounds.size(); i += 2) {
+                    std::inplace_merge(
+                        entries.begin() + bounds[i],
+                        entries.begin() + bounds[i + 1],
+                        entries.begin() + bounds[i + 2],
+                        cmp
+                    );
+                    merged.push_back(bounds[i]);
+                }
+                if (bounds.size() % 2 == 0)
+                    merged.push_back(bounds[bounds.size() - 2]);
+                merged.push_back(bounds.back());
+                bounds = std::move(merged);
+            }
+        }
+        if (job->cancelled)
+            return;
+        job->rows.reserve(entries.size());
+        for (auto &e : entries)
+            job->rows.push_back(e.second);
+        job->ready = true;
+    }
+
+  protected:
+    void draw_cell(
+        TableContext context,
+        int r = 0,
+        int c = 0,
+        int x = 0,
+        int y = 0,
+        int w = 0,
+        int h = 0
+    ) override {
+        std::array<char, 64> buf = {};
+        switch (context) {
+        case CONTEXT_STARTPAGE:
+            fl_font(FL_HELVETICA, FL_NORMAL_SIZE);
+            return;
+        case CONTEXT_COL_HEADER: {
+            fl_push_clip(x, y, w, h);
+            fl_draw_box(FL_THIN_UP_BOX, x, y, w, h, FL_BACKGROUND_COLOR);
+            fl_color(FL_FOREGROUND_COLOR);
+            if (source_ && (std::size_t)c < source_->cols()) {
+                auto text = std::string(source_->header(c));
+                if (c == sort_col_)
+                    text += sort_asc_ ? " @-22>" : " @-28>";
+                fl_draw(text.c_str(), x + 4, y, w - 8, h, FL_ALIGN_LEFT);
+            }
+            fl_pop_clip();
+            return;
+        }
+        case CONTEXT_CELL: {
+            if (!source_)
+                return;
+            auto row = perm_ ? (*perm_)[r] : (std::size_t)r;
+            fl_push_clip(x, y, w, h);
+            auto selected = row_selected(r);
+            fl_color(selected ? selection_color() : FL_BACKGROUND2_COLOR);
+            fl_rectf(x, y, w, h);
+            fl_color(FL_FOREGROUND_COLOR);
+            auto text = source_->cell(row, c, buf);
+            fl_draw(
+                text.data(),
+                (int)text.size(),
+                x + 4,
+                y + h - fl_descent() - 2
+            );
+            fl_color(FL_LIGHT2);
+            fl_rect(x, y, w, h);
+            fl_pop_clip();
+            return;
+        }
+        default:
+            return;
+        }
+    }
+
+  public:
+    DataTable(int x, int y, int w, int h, const char *label = nullptr)
+        : Fl_Table_Row(x, y, w, h, label) {
+        col_header(1);
+        col_resize(1);
+        end();
+    }
+    DataTable(const DataTable &)            = delete;
+    DataTable &operator=(const DataTable &) = delete;
+    ~DataTable() override {
+        Fl::remove_timeout(poll_cb, this);
+        if (job_)
+            job_->cancelled = true;
+    }
+    int handle(int event) override {
+        if (event == FL_PUSH && Fl::event_button() == 1) {
+            int r = 0, c = 0;
+            ResizeFlag flag = RESIZE_NONE;
+            if (cursor2rowcol(r, c, flag) == CONTEXT_COL_HEADER &&
+                flag == RESIZE_NONE) {
+                sort(c, c == sort_col_ ? !sort_asc_ : true);
+                return 1;
+            }
+        }
+        return Fl_Table_Row::handle(event);
+    }
+    /// Subtypes select the row selection mode
+    void type(int mode) { Fl_Table_Row::type((TableRowSelectMode)mode); }
+    /// Display another source
+    void source(std::shared_ptr<TableSource> source) {
+        source_ = std::move(source);
+        perm_.reset();
+        cols(source_ ? (int)source_->cols() : 0);
+        sync_rows();
+        if (sort_col_ >= 0 || filter_)
+            recompute();
+        else
+            watch();
+    }
+    /// Sort by a column, or restore source order with col < 0
+    void sort(int col, bool ascending) {
+        sort_col_ = col;
+        sort_asc_ = ascending;
+        recompute();
+    }
+    /// Only show rows matching filter, or all rows if it is empty
+    void filter(TableFilter filter) {
+        filter_ = std::move(filter);
+        recompute();
+    }
+    /// Start computing the row permutation for the current sort and filter
+    void recompute() {
+        if (job_)
+            job_->cancelled = true;
+        job_.reset();
+        if (!source_ || (sort_col_ < 0 && !filter_)) {
+            perm_.reset();
+            sync_rows();
+            watch();
+            return;
+        }
+        job_ = std::make_shared<Job>();
+        ThreadPool::global().submit([job       = job_,
+                                     source    = source_,
+                                     filter    = filter_,
+                                     col       = sort_col_,
+                                     ascending = sort_asc_] {
+            compute(job, source, filter, col, ascending);
+        });
+        redraw();
+        watch();
+    }
+    /// Map a displayed row to its source row
+    [[nodiscard]] std::size_t source_row(int r) const {
+        return perm_ ? (*perm_)[r] : (std::size_t)r;
+    }
+};
+
+template <class B>
+struct TableProps {
+    std::optional<std::shared_ptr<TableSource>> source;
+    std::optional<std::pair<int, bool>> sort;
+    /// Filters are compared by key, the predicate itself is not comparable
+    std::optional<std::string> filter_key;
+    TableFilter filter;
+    std::optional<int> col_width;
+    std::optional<int> row_height;
+    void view(B *w) {
+        if (col_width)
+            w->col_width_all(*col_width);
+        if (row_height)
+            w->row_height_all(*row_height);
+        if (filter_key)
+            w->filter(filter);
+        if (sort)
+            w->sort(sort->first, sort->second);
+        if (source)
+            w->source(*source);
+    }
+    void update(B *w, const TableProps &other) {
+        if (*this == other)
+            return;
+        if (other.source != source) {
+            source = other.source;
+            w->source(source ? *source : nullptr);
+        }
+        if (other.filter_key != filter_key) {
+            filter_key = other.filter_key;
+            filter     = other.filter;
+            w->filter(filter_key ? filter : TableFilter());
+        }
+        if (other.sort != sort) {
+            sort = other.sort;
+            if (sort)
+                w->sort(sort->first, sort->second);
+        }
+        if (other.col_width != col_width) {
+            col_width = other.col_width;
+            if (col_width)
+                w->col_width_all(*col_width);
+        }
+        if (other.row_height != row_height) {
+            row_height = other.row_height;
+            if (row_height)
+                w->row_height_all(*row_height);
+        }
+    }
+    bool operator==(const TableProps &other) const {
+        return source == other.source && sort == other.sort &&
+               filter_key == other.filter_key &&
+               col_width == other.col_width && row_height == other.row_height;
+    }
+    void hash(Hasher &h) const {
+        h(source, sort, filter_key, col_width, row_height);
+    }
+};
+
+template <class Message, class W, class B>
+class TableBase : public WidgetBase<Message, W, B> {
+  protected:
+    TableProps<B> tprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        tprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               tprops == other.tprops;
+    }
+
+  public:
+    std::shared_ptr<Widget<Message>> create() override {
+        return std::shared_ptr<Widget<Message>>(new W(*(W *)this));
+    }
+    Fl_Widget *view() override {
+        WidgetBase<Message, W, B>::view();
+        this->tprops.view(this->inner);
+        return this->inner;
+    }
+    void update(Widget<Message> *other) override {
+        auto f = (W *)other;
+        WidgetBase<Message, W, B>::update(other);
+        this->tprops.update(this->inner, f->tprops);
+    }
+    virtual ~TableBase() = default;
+
+    /// Set the data source
+    W &source(std::shared_ptr<TableSource> source) {
+        tprops.source = std::move(source);
+        return *(W *)this;
+    }
+    /// Sort by a column
+    W &sort(int col, bool ascending = true) {
+        tprops.sort = std::make_pair(col, ascending);
+        return *(W *)this;
+    }
+    /// Filter rows; the filter only re-runs when key changes
+    W &filter(std::string_view key, TableFilter filter) {
+        tprops.filter_key = std::string(key);
+        tprops.filter     = std::move(filter);
+        return *(W *)this;
+    }
+    /// Set the width of all columns
+    W &col_width(int w) {
+        tprops.col_width = w;
+        return *(W *)this;
+    }
+    /// Set the height of all rows
+    W &row_height(int h) {
+        tprops.row_height = h;
+        return *(W *)this;
+    }
+};
+
+#define TABLE(Class, Base)                                                     \
+    template <class Message>                                                   \
+    class Class : public TableBase<Message, Class<Message>, Base> {};
+
+TABLE(Table, DataTable)
+} // namespace detail
+} // namespace rf
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "widget.hpp"
+#include <FL/Enumerations.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Scrollbar.H>
+#include <FL/fl_draw.H>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <string_view>
+
+namespace rf::detail {
+
+/// A scrollable display of text lines which only draws the visible rows.
+/// Subclasses provide the line count and visit the lines in view, so the
+/// text never has to be copied into the widget.
+class LineDisplay : public Fl_Group {
+    Fl_Scrollbar vscroll_;
+    std::size_t top_ = 0;
+    int line_height_ = 0;
+
+    /// Bytes drawn per line at most, so huge lines stay cheap
+    static constexpr std::size_t max_draw = 4096;
+
+    static void scroll_cb(Fl_Widget *w, void *data) {
+        auto *self = static_cast<LineDisplay *>(data);
+        self->top_ = (std::size_t)static_cast<Fl_Scrollbar *>(w)->value();
+        self->redraw();
+    }
+    [[nodiscard]] int text_x() const { return x() + Fl::box_dx(box()); }
+    [[nodiscard]] int text_y() const { return y() + Fl::box_dy(box()); }
+    [[nodiscard]] int text_w() const {
+        return w() - Fl::box_dw(box()) - Fl::scrollbar_size();
+    }
+    [[nodiscard]] int text_h() const { return h() - Fl::box_dh(box()); }
+
+  protected:
+    using Visitor = std::function<void(std::size_t, std::string_view)>;
+    Fl_Font textfont_     = FL_COURIER;
+    Fl_Fontsize textsize_ = FL_NORMAL_SIZE;
+    Fl_Color textcolor_   = FL_FOREGROUND_COLOR;
+    [[nodiscard]] virtual std::size_t line_count() const = 0;
+    /// Call f(i, text) for each available line in [first, first + n)
+    virtual void
+    visit_lines(std::size_t first, std::size_t n, const Visitor &f) = 0;
+
+    void draw() override {
+        fl_font(textfont_, textsize_);
+        line_height_ = fl_height();
+        sync();
+        if (damage() & ~FL_DAMAGE_CHILD) {
+            draw_box();
+            fl_push_clip(text_x(), text_y(), text_w(), text_h());
+            fl_color(active_r() ? textcolor_ : fl_inactive(textcolor_));
+            auto descent = fl_descent();
+            visit_lines(top_, rows(), [&](std::size_t i, std::string_view s) {
+                auto row = (int)(i - top_) + 1;
+                fl_draw(
+                    s.data(),
+                    (int)std::min(s.size(), max_draw),
+                    text_x() + 2,
+                    text_y() + row * line_height_ - descent
+                );
+            });
+            fl_pop_clip();
+            draw_child(vscroll_);
+        } else {
+            update_child(vscroll_);
+        }
+    }
+
+  public:
+    LineDisplay(int x, int y, int w, int h, const char *label = nullptr)
+        : Fl_Group(x, y, w, h, label), vscroll_(x, y, 0, 0) {
+        end();
+        box(FL_DOWN_BOX);
+        color(FL_BACKGROUND2_COLOR);
+        vscroll_.callback(scroll_cb, this);
+        place_scrollbar();
+    }
+    void resize(int x, int y, int w, int h) override {
+        Fl_Widget::resize(x, y, w, h);
+        place_scrollbar();
+        sync();
+    }
+    void place_scrollbar() {
+        auto sb = Fl::scrollbar_size();
+        vscroll_.resize(
+            x() + w() - Fl::box_dx(box()) - sb, text_y(), sb, text_h()
+        );
+    }
+    int handle(int event) override {
+        switch (event) {
+        case FL_MOUSEWHEEL:
+            scroll_by((long long)Fl::event_dy() * 3);
+            return 1;
+        case FL_FOCUS:
+        case FL_UNFOCUS:
+            return 1;
+        case FL_PUSH:
+            if (Fl_Group::handle(event))
+                return 1;
+            take_focus();
+            return 1;
+        case FL_KEYDOWN:
+            switch (Fl::event_key()) {
+            case FL_Up:
+                scroll_by(-1);
+                return 1;
+            case FL_Down:
+                scroll_by(1);
+                return 1;
+            case FL_Page_Up:
+                scroll_by(-(long long)rows() + 1);
+                return 1;
+            case FL_Page_Down:
+                scroll_by((long long)rows() - 1);
+                return 1;
+            case FL_Home:
+                top_line(0);
+                return 1;
+            case FL_End:
+                scroll_to_bottom();
+                return 1;
+            default:
+                break;
+            }
+            break;
+        default:
+            break;
+        }
+        return Fl_Group::handle(event);
+    }
+    /// Number of rows that fit in the widget
+    [[nodiscard]] std::size_t rows() const {
+        auto lh = line_height_ ? line_height_ : textsize_ + 2;
+        return (std::size_t)std::max(text_h() / lh, 1);
+    }
+    /// Get the first visible line
+    [[nodiscard]] std::size_t top_line() const { return top_; }
+    /// Scroll so that line is the first visible one
+    void top_line(std::size_t line) {
+        auto count = line_count();
+        auto max   = count > rows() ? count - rows() : 0;
+        line       = std::min(line, max);
+        if (line != top_) {
+            top_ = line;
+            redraw();
+        }
+        sync();
+    }
+    void scroll_by(long long delta) {
+        auto target = (long long)top_ + delta;
+        top_line((std::size_t)std::max(target, 0LL));
+    }
+    /// Whether the last line is in view
+    [[nodiscard]] bool at_bottom() const {
+        return top_ + rows() >= line_count();
+    }
+    void scroll_to_bottom() { top_line(line_count()); }
+    /// Refresh the scrollbar after the number of lines changed
+    void lines_changed() {
+        sync();
+        redraw();
+    }
+    /// Update the scrollbar to the current position and line count
+    void sync() {
+        auto count = std::min<std::size_t>(line_count(), INT_MAX);
+        auto rs    = std::min<std::size_t>(rows(), INT_MAX);
+        vscroll_.value(
+            (int)std::min<std::size_t>(top_, INT_MAX),
+            (int)rs,
+            0,
+            (int)std::max(count, rs)
+        );
+    }
+    void textfont(Fl_Font f) {
+        textfont_ = f;
+        redraw();
+    }
+    void textsize(Fl_Fontsize s) {
+        textsize_    = s;
+        line_height_ = 0;
+        redraw();
+    }
+    void textcolor(Fl_Color c) {
+        textcolor_ = c;
+        redraw();
+    }
+};
+
+/// A read-only view of a memory-mapped file.
+/// Opening is instant: line offsets are indexed on a background thread and
+/// the scrollbar grows as indexing progresses.
+class MappedTextDisplay : public LineDisplay {
+    std::unique_ptr<LineIndex> index_;
+    std::size_t seen_ = 0;
+
+    static void poll_cb(void *data) {
+        auto *self = static_cast<MappedTextDisplay *>(data);
+        if (!self->index_)
+            return;
+        auto n = self->index_->lines();
+        if (n != self->seen_) {
+            self->seen_ = n;
+            self->lines_changed();
+        }
+        if (!self->index_->done() || n != self->index_->lines())
+            Fl::repeat_timeout(0.1, poll_cb, data); // NOLINT
+    }
+
+  protected:
+    [[nodiscard]] std::size_t line_count() const override { return seen_; }
+    void visit_lines(
+        std::size_t first, std::size_t n, const Visitor &f
+    ) override {
+        if (index_ && first < seen_)
+            index_->visit(first, std::min(n, seen_ - first), f);
+    }
+
+  public:
+    MappedTextDisplay(int x, int y, int w, int h, const char *label = nullptr)
+        : LineDisplay(x, y, w, h, label) {}
+    MappedTextDisplay(const MappedTextDisplay &)            = delete;
+    MappedTextDisplay &operator=(const MappedTextDisplay &) = delete;
+    ~MappedTextDisplay() override { Fl::remove_timeout(poll_cb, this); }
+    /// Map a file, replacing the current one
+    void open(const std::string &path) {
+        Fl::remove_timeout(poll_cb, this);
+        index_.reset();
+        seen_ = 0;
+        top_line(0);
+        auto file = std::make_shared<const MappedFile>(path);
+        if (file->valid()) {
+            index_ = std::make_unique<LineIndex>(file);
+            Fl::add_timeout(0.02, poll_cb, this); // NOLINT
+        }
+        lines_changed();
+    }
+    /// Whether the background indexing is still running
+    [[nodiscard]] bool indexing() const { return index_ && !index_->done(); }
+};
+
+template <class B>
+struct TextViewProps {
+    std::optional<std::string> path;
+    std::optional<Color> textcolor;
+    std::optional<Font> textfont;
+    std::optional<int> textsize;
+    std::optional<std::size_t> topline;
+    void view(B *w) {
+        if (textcolor)
+            w->textcolor(*textcolor);
+        if (textfont)
+            w->textfont(*textfont);
+        if (textsize)
+            w->textsize(*textsize);
+        if (path)
+            w->open(*path);
+        if (topline)
+            w->top_line(*topline);
+    }
+    void update(B *w, const TextViewProps &other) {
+        if (*this == other)
+            return;
+        if (other.path != path) {
+            path = other.path;
+            w->open(path ? *path : std::string());
+        }
+        if (other.textcolor != textcolor) {
+            textcolor = other.textcolor;
+            if (textcolor)
+                w->textcolor(*textcolor);
+        }
+        if (other.textfont != textfont) {
+            textfont = other.textfont;
+            if (textfont)
+                w->textfont(*textfont);
+        }
+        if (other.textsize != textsize) {
+            textsize = other.textsize;
+            if (textsize)
+                w->textsize(*textsize);
+        }
+        if (other.topline != topline) {
+            topline = other.topline;
+            if (topline)
+                w->top_line(*topline);
+        }
+    }
+    bool operator==(const TextViewProps &) const = default;
+    void hash(Hasher &h) const {
+        h(path, textcolor, textfont, textsize, topline);
+    }
+};
+
+template <class Message, class W, class B>
+class TextViewBase : public WidgetBase<Message, W, B> {
+  protected:
+    TextViewProps<B> tprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        tprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               tprops == other.tprops;
+    }
+
+  public:
+    std::shared_ptr<Widget<Message>> create() override {
+        return std::shared_ptr<Widget<Message>>(new W(*(W *)this));
+    }
+    Fl_Widget *view() override {
+        WidgetBase<Message, W, B>::view();
+        this->tprops.view(this->inner);
+        return this->inner;
+    }
+    void update(Widget<Message> *other) override {
+        auto f = (W *)other;
+        WidgetBase<Message, W, B>::update(other);
+        this->tprops.update(this->inner, f->tprops);
+    }
+    virtual ~TextViewBase() = default;
+
+    /// Set the file to display
+    W &path(std::string_view path) {
+        tprops.path = std::string(path);
+        return *(W *)this;
+    }
+    /// Set the first visible line
+    W &topline(std::size_t line) {
+        tprops.topline = line;
+        return *(W *)this;
+    }
+    /// Set the text color
+    W &textcolor(Color col) {
+        tprops.textcolor = col;
+        return *(W *)this;
+    }
+    /// Set the text size
+    W &textsize(int sz) {
+        tprops.textsize = sz;
+        return *(W *)this;
+    }
+    /// Set the text font
+    W &textfont(Font font) {
+        tprops.textfont = font;
+        return *(W *)this;
+    }
+};
+
+#define TEXTVIEW(Class, Base)                                                  \
+    template <class Message>                                                   \
+    class Class : public TextViewBase<Message, Class<Message>, Base> {};
+
+TEXTVIEW(TextView, MappedTextDisplay)
+} // namespace rf::detail
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define REACTIF_TRACE_CAT2(a, b) a##b
+#define REACTIF_TRACE_CAT(a, b) REACTIF_TRACE_CAT2(a, b)
+/// Record a span named by the string literal name until the end of the scope
+#define REACTIF_TRACE_SCOPE(name)                                              \
+    rf::detail::TraceScope REACTIF_TRACE_CAT(reactif_trace_, __LINE__)(name)
+
+namespace rf::detail {
+
+/// Whether spans are being recorded. Checked first by every span, so that
+/// disabled tracing costs a single branch.
+inline std::atomic<bool> &tracing() {
+    static std::atomic<bool> on = false;
+    return on;
+}
+
+/// A finished span. The name must be a string literal.
+struct TraceEvent {
+    const char *name;
+    std::uint64_t start_ns;
+    std::uint64_t dur_ns;
+};
+
+/// Spans recorded by one thread and drained by the flushing thread, without
+/// locks. Spans recorded while the ring is full are dropped.
+class TraceRing {
+    static constexpr std::size_t capacity = std::size_t(1) << 14;
+    std::array<TraceEvent, capacity> events_;
+    std::atomic<std::uint64_t> head_    = 0;
+    std::atomic<std::uint64_t> tail_    = 0;
+    std::atomic<std::uint64_t> dropped_ = 0;
+
+  public:
+    const std::uint32_t tid;
+    const char *const thread_name;
+    TraceRing(std::uint32_t tid, const char *thread_name)
+        : tid(tid), thread_name(thread_name) {}
+    /// Called only by the owning thread
+    void push(const TraceEvent &e) {
+        auto h = head_.load(std::memory_order_relaxed);
+        if (h - tail_.load(std::memory_order_acquire) == capacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events_[h % capacity] = e;
+        head_.store(h + 1, std::memory_order_release);
+    }
+    /// Called only by the flushing thread
+    template <class F>
+    void drain(F &&f) {
+        auto t = tail_.load(std::memory_order_relaxed);
+        auto h = head_.load(std::memory_order_acquire);
+        for (; t != h; t++)
+            f(events_[t % capacity]);
+        tail_.store(t, std::memory_order_release);
+    }
+    [[nodiscard]] std::uint64_t dropped() const { return dropped_.load(); }
+};
+
+/// Collects the spans of every thread into a Chrome trace-event JSON file,
+/// which chrome://tracing and Perfetto open
+class Tracer {
+    using Clock = std::chrono::steady_clock;
+    std::mutex mtx_;
+    std::vector<std::shared_ptr<TraceRing>> rings_;
+    std::FILE *file_ = nullptr;
+    std::string buf_;
+    bool first_ = true;
+    Clock::time_point epoch_;
+    std::thread::id opener_;
+
+    void append(const TraceRing &r, const TraceEvent &e) {
+        char line[256];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f}",
+            first_ ? "" : ",",
+            e.name,
+            r.tid,
+            (double)e.start_ns / 1000,
+            (double)e.dur_ns / 1000
+        );
+        buf_ += line;
+        first_ = false;
+    }
+    void append_thread_name(const TraceRing &r) {
+        char line[256];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"name\":\"%s\"}}",
+            first_ ? "" : ",",
+            r.tid,
+            r.thread_name
+        );
+        buf_ += line;
+        first_ = false;
+    }
+
+  public:
+    Tracer() = default;
+    Tracer(const Tracer &)            = delete;
+    Tracer &operator=(const Tracer &) = delete;
+    ~Tracer() { close(); }
+    static Tracer &global() {
+        static Tracer tracer;
+        return tracer;
+    }
+    /// Start recording spans to a new trace file. The calling thread is
+    /// named the UI thread.
+    bool open(const std::string &path) {
+        close();
+        std::lock_guard<std::mutex> lock(mtx_);
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_)
+            return false;
+        std::fputs("[", file_);
+        first_    = true;
+        epoch_    = Clock::now();
+        opener_   = std::this_thread::get_id();
+        tracing() = true;
+        for (const auto &r : rings_)
+            append_thread_name(*r);
+        return true;
+    }
+    /// Nanoseconds since open()
+    [[nodiscard]] std::uint64_t now_ns() const {
+        return (std::uint64_t)std::chrono::duration_cast<
+                   std::chrono::nanoseconds>(Clock::now() - epoch_)
+            .count();
+    }
+    /// The calling thread's ring, registered on first use
+    TraceRing &ring() {
+        thread_local std::shared_ptr<TraceRing> ring;
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto ui = std::this_thread::get_id() == opener_;
+            ring    = std::make_shared<TraceRing>(
+                (std::uint32_t)rings_.size() + 1, ui ? "ui" : "worker"
+            );
+            rings_.push_back(ring);
+            if (file_)
+                append_thread_name(*ring);
+        }
+        return *ring;
+    }
+    /// Write the spans recorded so far to the file
+    void flush() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!file_)
+            return;
+        for (const auto &r : rings_)
+            r->drain([&](const TraceEvent &e) { append(*r, e); });
+        std::fwrite(buf_.data(), 1, buf_.size(), file_);
+        buf_.clear();
+    }
+    /// Stop recording and finish the file
+    void close() {
+        if (!tracing())
+            return;
+        tracing() = false;
+        flush();
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::fputs("\n]\n", file_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+};
+
+/// Records a span from construction to the end of the scope while tracing
+class TraceScope {
+    const char *name_;
+    std::uint64_t start_ = 0;
+    bool on_             = false;
+
+  public:
+    /// name must be a string literal
+    explicit TraceScope(const char *name) : name_(name) {
+        if (tracing().load(std::memory_order_relaxed)) [[unlikely]] {
+            on_    = true;
+            start_ = Tracer::global().now_ns();
+        }
+    }
+    TraceScope(const TraceScope &)            = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+    ~TraceScope() {
+        if (on_) [[unlikely]] {
+            auto &tracer = Tracer::global();
+            tracer.ring().push({name_, start_, tracer.now_ns() - start_});
+        }
+    }
+};
+} // namespace rf::detail
@@ -14,6 +14,7 @@ class TreeItem {
     /// Create a tree item with a label
     TreeItem(std::string_view label) : label_(std::string(label)) {}
     bool operator==(const TreeItem &) const = default;
+    void hash(Hasher &h) const { h(label_, labelsize); }
     void view(Fl_Tree *m) const {
         auto i = m->add(label_.c_str());
         i->labelsize(labelsize);
@@ -54,12 +55,21 @@ struct TreeProps {
         }
     }
     bool operator==(const TreeProps &) const = default;
+    void hash(Hasher &h) const { h(items, root_label); }
 };
 
 template <class Message, class W, class B>
 class TreeBase : public WidgetBase<Message, W, B> {
   protected:
     TreeProps<Message, B> tprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        tprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               tprops == other.tprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
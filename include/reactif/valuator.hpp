@@ -71,12 +71,21 @@ struct ValuatorProps {
         }
     }
     bool operator==(const ValuatorProps &) const = default;
+    void hash(Hasher &h) const { h(value, minimum, maximum, step, precision); }
 };
 
 template <class Message, class W, class B>
 class ValuatorBase : public WidgetBase<Message, W, B> {
   protected:
     ValuatorProps<B> vprops = {};
+    void hash_props(Hasher &h) const override {
+        WidgetBase<Message, W, B>::hash_props(h);
+        vprops.hash(h);
+    }
+    bool same_props(const W &other) const override {
+        return WidgetBase<Message, W, B>::same_props(other) &&
+               vprops == other.vprops;
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -1,13 +1,34 @@
 #pragma once
 
+#include "animate.hpp"
+#include "draw_profile.hpp"
 #include "enums.hpp"
+#include "function.hpp"
+#include "label.hpp"
+#include "profile.hpp"
+#include "stats.hpp"
 #include <FL/Enumerations.H>
+#include <FL/Fl.H>
 #include <FL/Fl_Flex.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Image_Surface.H>
 #include <FL/Fl_Widget.H>
+#include <FL/fl_draw.H>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 namespace rf {
 
@@ -20,41 +41,408 @@ class Widget {
     virtual Fl_Widget *view() = 0;
     /// Update the properties of the widget
     virtual void update(Widget *) = 0;
-    virtual ~Widget()             = default;
+    /// Update the widget's own properties but not its children, which the
+    /// caller patches separately
+    virtual void update_shallow(Widget *other) { update(other); }
+    /// Take other's hash once the children were patched separately and the
+    /// node's own props are unchanged
+    virtual void refresh(Widget *) {}
+    /// Whether other, a node of the same type, has the same own props,
+    /// children aside. Only reads the nodes, so it may run on any thread.
+    [[nodiscard]] virtual bool props_equal(const Widget *) const {
+        return false;
+    }
+    /// The node's children
+    [[nodiscard]] virtual std::span<const std::shared_ptr<Widget>>
+    child_nodes() const {
+        return {};
+    }
+    /// A hash of the node's props and its children's hashes, or 0 if
+    /// unknown. The reconciler skips subtrees whose hash matches.
+    [[nodiscard]] virtual std::uint64_t hash() const { return 0; }
+#ifdef REACTIF_PROFILE
+    Widget() { detail::profile_counters().live_nodes++; }
+    Widget(const Widget &) { detail::profile_counters().live_nodes++; }
+    Widget &operator=(const Widget &) = default;
+    virtual ~Widget() { detail::profile_counters().live_nodes--; }
+#else
+    virtual ~Widget() = default;
+#endif
 };
 
 namespace detail {
 
+/// Accumulates the structural hash of a node. Callbacks are left out where
+/// update() does not replace them either.
+class Hasher {
+    std::uint64_t h_ = 0x9e3779b97f4a7c15;
+    bool unknown_    = false;
+
+  public:
+    /// Mix a word into the hash (splitmix64)
+    Hasher &mix(std::uint64_t v) {
+        auto z = h_ + v + 0x9e3779b97f4a7c15;
+        z      = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z      = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        h_     = z ^ (z >> 31);
+        return *this;
+    }
+    /// Make the hash unknown, e.g. for a child that cannot be hashed
+    Hasher &unknown() {
+        unknown_ = true;
+        return *this;
+    }
+    template <class T>
+    Hasher &operator()(const T &v) {
+        if constexpr (requires { v.hash(*this); }) {
+            v.hash(*this);
+        } else if constexpr (requires { v.c_str(); }) {
+            mix(std::hash<std::string_view>()(v.c_str()));
+        } else if constexpr (std::is_convertible_v<T, std::string_view>) {
+            mix(std::hash<std::string_view>()(v));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            mix(std::bit_cast<std::uint64_t>((double)v));
+        } else if constexpr (requires { v.has_value(); *v; }) {
+            mix(v.has_value());
+            if (v)
+                (*this)(*v);
+        } else if constexpr (requires { v.get(); }) {
+            mix((std::uintptr_t)v.get());
+        } else if constexpr (requires { std::tuple_size<T>::value; }) {
+            std::apply([this](const auto &...e) { ((*this)(e), ...); }, v);
+        } else if constexpr (requires { v.begin(); v.size(); }) {
+            mix(v.size());
+            for (const auto &e : v)
+                (*this)(e);
+        } else {
+            mix(static_cast<std::uint64_t>(v));
+        }
+        return *this;
+    }
+    template <class T, class... Ts>
+    Hasher &operator()(const T &v, const Ts &...vs) {
+        (*this)(v);
+        ((*this)(vs), ...);
+        return *this;
+    }
+    /// The hash, never 0 unless it is unknown
+    [[nodiscard]] std::uint64_t value() const {
+        return unknown_ ? 0 : h_ ? h_ : 1;
+    }
+};
+
+/// Set by a window during a live resize, while containers below the
+/// top-level ones only take their new size and put off laying out their
+/// children until resizing settles
+inline bool &deferring_layout() {
+    static bool deferring = false;
+    return deferring;
+}
+
+/// Called just before a wrapped widget is deleted, while its state can
+/// still be read. Found on a plain Fl_Widget with dynamic_cast.
+struct DeleteHook {
+    void (*on_delete)(void *) = nullptr;
+    void *on_delete_data      = nullptr;
+};
+
 template <class T>
     requires(std::is_base_of_v<Fl_Widget, T>)
-class FlWidgetWrapper : public T {
+class FlWidgetWrapper : public T, public DeleteHook {
   public:
     std::function<void(FlWidgetWrapper *, int, int, int, int)> resize_cb;
-    std::shared_ptr<std::function<void(FlWidgetWrapper *)>> cb_;
+    InlineFunction<void(FlWidgetWrapper *)> cb_;
     FlWidgetWrapper(int x, int y, int w, int h, const char *label = nullptr)
-        : T(x, y, w, h, label) {}
+        : T(x, y, w, h, label) {
+#ifdef REACTIF_PROFILE
+        profile_counters().live_widgets++;
+#endif
+    }
+    ~FlWidgetWrapper() {
+#ifdef REACTIF_PROFILE
+        profile_counters().live_widgets--;
+#endif
+        if (on_delete)
+            on_delete(on_delete_data);
+        if (debounced_)
+            Fl::remove_timeout(debounce_cb, this);
+        if (offscreen_)
+            fl_delete_offscreen(offscreen_);
+    }
     void resize(int x, int y, int w, int h) override {
-        T::resize(x, y, w, h);
+        if constexpr (std::is_base_of_v<Fl_Group, T>) {
+            auto *parent = this->parent();
+            if (deferring_layout() && parent && !parent->as_window()) {
+                if (!laid_out_)
+                    laid_out_ = {this->x(), this->y(), this->w(), this->h()};
+                Fl_Widget::resize(x, y, w, h);
+                frame_stats().deferred_relayouts++;
+                return;
+            }
+            // Children are still placed for the last size laid out
+            if (laid_out_) {
+                auto [lx, ly, lw, lh] = *laid_out_;
+                Fl_Widget::resize(lx, ly, lw, lh);
+                laid_out_.reset();
+            }
+            frame_stats().relayouts++;
+        }
+        if constexpr (std::is_base_of_v<Fl_Flex, T>) {
+            if (!layout_from_cache(x, y, w, h)) {
+                T::resize(x, y, w, h);
+                layout_to_cache();
+            }
+        } else {
+            T::resize(x, y, w, h);
+        }
         if (resize_cb)
-            resize_cb(this, x, y, h, w);
-    }
-    void cb(std::function<void(FlWidgetWrapper *)> &&f) {
-        cb_ = std::make_shared<std::function<void(FlWidgetWrapper *)>>(f);
-        this->callback(
-            [](auto *w, auto *data) {
-                if (data) {
-                    auto cb = (std::function<void(FlWidgetWrapper *)> *)data;
-                    (*cb)((FlWidgetWrapper *)w);
-                }
-            },
-            cb_.get()
-        );
+            resize_cb(this, x, y, w, h);
+    }
+    /// Forget cached layouts after a change to the constraints of a Flex or
+    /// its children, and lay it out again before the next draw
+    void layout_dirty() {
+        if constexpr (std::is_base_of_v<Fl_Flex, T>) {
+            layouts_.clear();
+            this->need_layout(1);
+        }
+    }
+    /// Set the callback, kept inside the wrapper
+    void cb(InlineFunction<void(FlWidgetWrapper *)> &&f) {
+        cb_ = std::move(f);
+        this->callback([](Fl_Widget *w, void *) {
+            auto *self = (FlWidgetWrapper *)w;
+            if (self->cb_)
+                self->cb_(self);
+        });
+    }
+    /// Run f once no further call has been made for secs seconds
+    void debounce(double secs, std::function<void()> &&f) {
+        debounced_ = std::move(f);
+        Fl::remove_timeout(debounce_cb, this);
+        Fl::add_timeout(secs, debounce_cb, this);
+    }
+    /// Draw a group's subtree from an offscreen copy while it is unchanged
+    void cached(bool on) {
+        cached_ = on;
+        invalidate_cache();
+        if (!on && offscreen_) {
+            fl_delete_offscreen(offscreen_);
+            offscreen_ = 0;
+        }
+    }
+    /// Render the subtree again on the next full redraw. The reconciler
+    /// calls this whenever it patches the group or anything below it.
+    void invalidate_cache() { cache_valid_ = false; }
+
+    /// Name the widget in draw profiles instead of its type
+    void profile_key(std::string_view key) {
+        profile_key_ = key;
+        draw_cost_   = nullptr;
+    }
+    /// Count a change to the widget's props in draw profiles
+    void note_change() {
+        if (DrawProfiler::global().enabled())
+            draw_cost().changes++;
+    }
+
+  protected:
+    void draw() override {
+        auto &profiler = DrawProfiler::global();
+        if (profiler.enabled())
+            profiler.time(draw_cost(), [this] { draw_widget(); });
+        else
+            draw_widget();
+    }
+
+  private:
+    void draw_widget() {
+        if constexpr (std::is_base_of_v<Fl_Group, T>) {
+            if (cached_ && !rendering_) {
+                draw_cached();
+                return;
+            }
+        }
+        T::draw();
+    }
+    std::string profile_key_;
+    DrawCost *draw_cost_ = nullptr;
+    DrawCost &draw_cost() {
+        if (!draw_cost_) {
+            static const auto type = demangle(typeid(T).name());
+            draw_cost_             = &DrawProfiler::global().entry(
+                profile_key_.empty() ? type : profile_key_
+            );
+        }
+        return *draw_cost_;
+    }
+    /// Child rectangles of a Flex, relative to its origin, for one size
+    struct Layout {
+        int w = 0;
+        int h = 0;
+        std::vector<std::array<int, 4>> rects;
+    };
+    static constexpr std::size_t max_layouts = 4;
+    /// The rectangle of the last layout, while a live resize defers it
+    std::optional<std::array<int, 4>> laid_out_;
+    std::vector<Layout> layouts_;
+    std::size_t next_layout_ = 0;
+    bool layout_from_cache(int x, int y, int w, int h) {
+        auto &stats = frame_stats();
+        for (const auto &l : layouts_) {
+            if (l.w != w || l.h != h ||
+                l.rects.size() != (std::size_t)this->children())
+                continue;
+            Fl_Widget::resize(x, y, w, h);
+            for (int i = 0; i < this->children(); i++) {
+                auto *c               = this->child(i);
+                auto [cx, cy, cw, ch] = l.rects[i];
+                c->resize(x + cx, y + cy, cw, ch);
+            }
+            stats.layout_hits++;
+            return true;
+        }
+        stats.layout_misses++;
+        return false;
+    }
+    void layout_to_cache() {
+        Layout l{this->w(), this->h(), {}};
+        l.rects.reserve(this->children());
+        for (int i = 0; i < this->children(); i++) {
+            auto *c = this->child(i);
+            l.rects.push_back(
+                {c->x() - this->x(), c->y() - this->y(), c->w(), c->h()}
+            );
+        }
+        if (layouts_.size() < max_layouts) {
+            layouts_.push_back(std::move(l));
+        } else {
+            layouts_[next_layout_] = std::move(l);
+            next_layout_           = (next_layout_ + 1) % max_layouts;
+        }
+    }
+    std::function<void()> debounced_;
+    Fl_Offscreen offscreen_ = 0;
+    int offscreen_w_        = 0;
+    int offscreen_h_        = 0;
+    bool cached_            = false;
+    bool cache_valid_       = false;
+    bool rendering_         = false;
+    void draw_cached() {
+        auto w = this->w();
+        auto h = this->h();
+        // Damage inside the subtree is drawn directly and spoils the copy
+        if (this->damage() & FL_DAMAGE_CHILD)
+            cache_valid_ = false;
+        if (!(this->damage() & ~FL_DAMAGE_CHILD) || w <= 0 || h <= 0) {
+            T::draw();
+            return;
+        }
+        if (offscreen_ && (w != offscreen_w_ || h != offscreen_h_)) {
+            fl_delete_offscreen(offscreen_);
+            offscreen_ = 0;
+        }
+        if (!offscreen_) {
+            offscreen_   = fl_create_offscreen(w, h);
+            offscreen_w_ = w;
+            offscreen_h_ = h;
+            cache_valid_ = false;
+        }
+        if (!cache_valid_) {
+            Fl_Image_Surface surface(w, h, 0, offscreen_);
+            Fl_Surface_Device::push_current(&surface);
+            rendering_ = true;
+            surface.draw(this, 0, 0);
+            rendering_ = false;
+            Fl_Surface_Device::pop_current();
+            cache_valid_ = true;
+        }
+        fl_copy_offscreen(this->x(), this->y(), w, h, offscreen_, 0, 0);
+    }
+    static void debounce_cb(void *data) {
+        auto self = static_cast<FlWidgetWrapper *>(data);
+        if (self->debounced_)
+            self->debounced_();
     }
 };
 
+/// Convert a box type, registering its drawing functions on first use so
+/// that run() need not define every type up front
+inline Fl_Boxtype boxtype(BoxType b) {
+    auto i = (int)b;
+    if (i == 15 || i == 17)
+        fl_define_FL_SHADOW_BOX();
+    else if (i == 18 || i == 20)
+        fl_define_FL_ROUNDED_BOX();
+    else if (i == 19)
+        fl_define_FL_RSHADOW_BOX();
+    else if (i == 21)
+        fl_define_FL_RFLAT_BOX();
+    else if (i == 22 || i == 23)
+        fl_define_FL_ROUND_UP_BOX();
+    else if (i == 24 || i == 25)
+        fl_define_FL_DIAMOND_BOX();
+    else if (i >= 26 && i <= 29)
+        fl_define_FL_OVAL_BOX();
+    else if (i >= 30 && i <= 37)
+        fl_define_FL_PLASTIC_UP_BOX();
+    else if (i >= 38 && i <= 47)
+        fl_define_FL_GTK_UP_BOX();
+    else if (i >= 48 && i <= 55)
+        fl_define_FL_GLEAM_UP_BOX();
+    return (Fl_Boxtype)i;
+}
+
+/// Convert a label type, registering it on first use
+inline Fl_Labeltype labeltype(LabelType l) {
+    switch (l) {
+    case LabelType::Shadow:
+        return fl_define_FL_SHADOW_LABEL();
+    case LabelType::Engraved:
+        return fl_define_FL_ENGRAVED_LABEL();
+    case LabelType::Embossed:
+        return fl_define_FL_EMBOSSED_LABEL();
+    case LabelType::Multi:
+        return fl_define_FL_MULTI_LABEL();
+    case LabelType::Icon:
+        return fl_define_FL_ICON_LABEL();
+    case LabelType::Image:
+        return fl_define_FL_IMAGE_LABEL();
+    default:
+        return (Fl_Labeltype)l;
+    }
+}
+
+/// Whether a and b are known to have the same props and children
+template <class Message>
+bool same_hash(const Widget<Message> &a, const Widget<Message> &b) {
+    auto hash = b.hash();
+    return hash && hash == a.hash();
+}
+
+/// Whether the mounted node cur can be updated in place to match next.
+/// Nodes also held outside the trees being reconciled, such as those kept by
+/// a ChunkMemo, may be handed to the reconciler again, so they are never
+/// updated in place: a kept next is mounted as it is, to be skipped as the
+/// same pointer next time, and a kept cur is replaced rather than given
+/// another node's props.
+template <class Message>
+bool patchable(
+    const std::shared_ptr<Widget<Message>> &cur,
+    const std::shared_ptr<Widget<Message>> &next
+) {
+    return typeid(*cur) == typeid(*next) && cur.use_count() == 1 &&
+           next.use_count() == 1;
+}
+
+/// Mark w's layout, if it is a Flex, as needing to be computed again
+inline void layout_dirty(Fl_Widget *w) {
+    if (auto *flex = dynamic_cast<FlWidgetWrapper<Fl_Flex> *>(w))
+        flex->layout_dirty();
+}
+
 template <class Message, class B>
 struct WidgetProps {
-    std::optional<std::string> label;
+    std::optional<Label> label;
     std::optional<std::string> tooltip;
     std::optional<std::pair<int, int>> pos;
     std::optional<std::pair<int, int>> size;
@@ -71,10 +459,12 @@ struct WidgetProps {
     std::optional<Align> align;
     std::optional<bool> deactivated;
     std::optional<When> when;
+    std::vector<Animation> animations;
+    std::optional<std::string> key;
 
     void view(B *w) {
         if (label)
-            w->copy_label(label->c_str());
+            label->apply(w);
         if (tooltip)
             w->tooltip(label->c_str());
         if (pos || size) {
@@ -100,9 +490,9 @@ struct WidgetProps {
         if (labelfont)
             w->labelfont((Fl_Font)*labelfont);
         if (labeltype)
-            w->labeltype((Fl_Labeltype)*labeltype);
+            w->labeltype(detail::labeltype(*labeltype));
         if (box)
-            w->box((Fl_Boxtype)*box);
+            w->box(boxtype(*box));
         if (hidden) {
             if (*hidden)
                 w->hide();
@@ -119,6 +509,10 @@ struct WidgetProps {
             w->align(*align);
         if (when)
             w->when(*when);
+        for (const auto &a : animations)
+            Animator::global().start(w, a);
+        if (key)
+            static_cast<FlWidgetWrapper<B> *>(w)->profile_key(*key);
     }
     void update(B *w, const WidgetProps &other) {
         if (*this == other)
@@ -126,28 +520,33 @@ struct WidgetProps {
         if (other.label != label) {
             label = other.label;
             if (label)
-                w->copy_label(label->c_str());
+                label->apply(w);
         }
         if (other.tooltip != tooltip) {
             tooltip = other.tooltip;
             if (tooltip)
                 w->tooltip(tooltip->c_str());
         }
-        if (other.pos != pos) {
-            pos = other.pos;
-        }
-        if (other.size != size) {
-            size = other.size;
-        }
         if (other.pos != pos || other.size != size) {
+            pos                  = other.pos;
+            size                 = other.size;
             auto [x, y]          = pos ? *pos : std::pair(0, 0);
             auto [width, height] = size ? *size : std::pair(0, 0);
             w->resize(x, y, width, height);
+            layout_dirty(w->parent());
+        }
+        if (other.fixed != fixed) {
+            fixed      = other.fixed;
+            auto *flex = dynamic_cast<Fl_Flex *>(w->parent());
+            if (flex)
+                flex->fixed(w, fixed ? *fixed : 0);
+            layout_dirty(w->parent());
         }
         if (other.subtype != subtype) {
             subtype = other.subtype;
             if (subtype)
                 w->type(*subtype);
+            layout_dirty(w);
         }
         if (other.color != color) {
             color = other.color;
@@ -169,9 +568,15 @@ struct WidgetProps {
             labelsize = other.labelsize;
             w->labelsize(*labelsize);
         }
+        if (other.labeltype != labeltype) {
+            labeltype = other.labeltype;
+            if (labeltype)
+                w->labeltype(detail::labeltype(*labeltype));
+        }
         if (other.box != box) {
             box = other.box;
-            w->labelsize((Fl_Boxtype)*box);
+            if (box)
+                w->box(boxtype(*box));
         }
         if (other.hidden != hidden) {
             hidden = other.hidden;
@@ -181,6 +586,7 @@ struct WidgetProps {
                 else
                     w->show();
             }
+            layout_dirty(w->parent());
         }
         if (other.deactivated != deactivated) {
             deactivated = other.deactivated;
@@ -202,8 +608,37 @@ struct WidgetProps {
             if (when)
                 w->when(*when);
         }
+        if (other.animations != animations) {
+            auto &animator = Animator::global();
+            auto has       = [](const auto &v, const Animation &a) {
+                return std::find(v.begin(), v.end(), a) != v.end();
+            };
+            // Retarget tweens whose animation changed, stop dropped ones
+            for (const auto &a : other.animations)
+                if (!has(animations, a))
+                    animator.start(w, a);
+            for (const auto &a : animations)
+                if (std::none_of(
+                        other.animations.begin(),
+                        other.animations.end(),
+                        [&](const auto &b) { return b.prop == a.prop; }
+                    ))
+                    animator.stop(w, a.prop);
+            animations = other.animations;
+        }
+        if (other.key != key) {
+            key = other.key;
+            static_cast<FlWidgetWrapper<B> *>(w)->profile_key(key ? *key : "");
+        }
     }
     bool operator==(const WidgetProps &) const = default;
+    void hash(Hasher &h) const {
+        h(label, tooltip, pos, size, subtype, fixed, color, labelcolor);
+        h(selection_color, labelsize, labelfont, labeltype, box, hidden);
+        h(align, deactivated, when, key, animations.size());
+        for (const auto &a : animations)
+            h(a.prop, a.target, a.secs, a.easing);
+    }
 };
 
 template <class Message, class W, class B>
@@ -211,6 +646,33 @@ class WidgetBase : public Widget<Message> {
   protected:
     FlWidgetWrapper<B> *inner      = nullptr;
     WidgetProps<Message, B> wprops = {};
+    /// Add the node's props to h; widgets holding more state extend this
+    virtual void hash_props(Hasher &h) const {
+        h(typeid(W).hash_code());
+        wprops.hash(h);
+    }
+    /// Whether other has the same props, children aside; widgets holding
+    /// more state extend this along with hash_props()
+    virtual bool same_props(const W &other) const {
+        return wprops == other.wprops;
+    }
+    bool props_equal(const Widget<Message> *other) const override {
+        return same_props(*(const W *)other);
+    }
+    void refresh(Widget<Message> *other) override {
+        auto f  = (W *)other;
+        hash_   = f->hash_;
+        hashed_ = f->hashed_;
+    }
+    /// Whether updating to other changes the props. Differing hashes tell
+    /// when both are known; otherwise the props are compared.
+    bool changes(const W &other) const {
+        auto a = hash();
+        auto b = other.hash();
+        if (a && b)
+            return a != b;
+        return !same_props(other);
+    }
 
   public:
     std::shared_ptr<Widget<Message>> create() override {
@@ -219,17 +681,50 @@ class WidgetBase : public Widget<Message> {
     Fl_Widget *view() override {
         inner = new FlWidgetWrapper<B>(0, 0, 0, 0); // NOLINT
         wprops.view(inner);
+        inner->note_change();
         return inner;
     }
     void update(Widget<Message> *other) override {
         auto f = (W *)other;
+        if (DrawProfiler::global().enabled() && changes(*f))
+            inner->note_change();
+        // Mounted nodes are patched, never patched from
+        assert(!f->inner);
         wprops.update(inner, f->wprops);
+        // The props now match other's, and so does the hash
+        hash_   = f->hash_;
+        hashed_ = f->hashed_;
+    }
+    [[nodiscard]] std::uint64_t hash() const override {
+        if (!hashed_) {
+            Hasher h;
+            hash_props(h);
+            hash_   = h.value();
+            hashed_ = true;
+        }
+        return hash_;
     }
     virtual ~WidgetBase() = default;
 
     /// Set the label
     W &label(std::string_view label) {
-        wprops.label = label;
+        wprops.label = Label(label);
+        return *(W *)this;
+    }
+    /// Set the label from a literal, which FLTK uses without copying
+    W &label(Literal label) {
+        wprops.label = Label(label);
+        return *(W *)this;
+    }
+    /// Set the label from an interned string, which FLTK uses without copying
+    W &label(Interned label) {
+        wprops.label = Label(label);
+        return *(W *)this;
+    }
+    /// Set the label from a printf-style format, e.g. label_fmt("%d", n)
+    template <class... Args>
+    W &label_fmt(const char *fmt, Args... args) {
+        wprops.label = Label::format(fmt, args...);
         return *(W *)this;
     }
     /// Set the tooltip
@@ -307,6 +802,36 @@ class WidgetBase : public Widget<Message> {
         wprops.box = b;
         return *(W *)this;
     }
+    /// Name the widget in draw profiles, which otherwise group widgets by
+    /// type
+    W &key(std::string_view key) {
+        wprops.key = std::string(key);
+        return *(W *)this;
+    }
+    /// Tween prop from its current value to target over secs, without
+    /// going through update() and view() on every frame. A different
+    /// target in a later view retargets the running tween.
+    W &animate(
+        Prop prop,
+        AnimationTarget target,
+        double secs,
+        Easing easing = Easing::EaseInOut
+    ) {
+        auto &v = wprops.animations;
+        auto it = std::find_if(v.begin(), v.end(), [&](const auto &a) {
+            return a.prop == prop;
+        });
+        Animation a{prop, target.values(), secs, easing};
+        if (it != v.end())
+            *it = a;
+        else
+            v.push_back(a);
+        return *(W *)this;
+    }
+
+  private:
+    mutable std::uint64_t hash_ = 0;
+    mutable bool hashed_        = false;
 };
 } // namespace detail
 } // namespace rf
@@ -4,14 +4,50 @@
 #include "browser.hpp"
 #include "button.hpp"
 #include "group.hpp"
+#include "image.hpp"
 #include "input.hpp"
+#include "log.hpp"
 #include "menu.hpp"
 #include "output.hpp"
+#include "plot.hpp"
+#include "pool.hpp"
+#include "table.hpp"
+#include "text.hpp"
 #include "tree.hpp"
 #include "valuator.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
 
 namespace rf::detail {
 
+/// A subtree being built on the thread pool by spawn_view()
+template <class Message>
+class SpawnedView {
+    struct Slot {
+        std::shared_ptr<Widget<Message>> result;
+        /// Destroyed first, so a running build finishes before result goes
+        TaskGroup group;
+    };
+    std::unique_ptr<Slot> slot_ = std::make_unique<Slot>();
+
+  public:
+    template <class F>
+    explicit SpawnedView(F &&build) {
+        slot_->group.run([slot = slot_.get(), build = std::forward<F>(build)] {
+            slot->result = build();
+            // Hash on the worker too, while the subtree is still in cache
+            if (slot->result)
+                slot->result->hash();
+        });
+    }
+    /// Wait for the subtree, building it here if no worker has started it
+    std::shared_ptr<Widget<Message>> get() {
+        slot_->group.wait();
+        return slot_->result;
+    }
+};
+
 #define WIDGETFN(Class, Fn)                                                    \
     Class<Message> Fn() const { return Class<Message>(); }
 
@@ -64,6 +100,16 @@ class DefaultWidgets {
     WIDGETFN(Output, output)
     /// multiline_output() creates a MultilineOutput wrapper
     WIDGETFN(MultilineOutput, multiline_output)
+    /// text_view() creates a TextView wrapper
+    WIDGETFN(TextView, text_view)
+    /// log_view() creates a LogView wrapper
+    WIDGETFN(LogView, log_view)
+    /// table() creates a Table wrapper
+    WIDGETFN(Table, table)
+    /// plot() creates a Plot wrapper
+    WIDGETFN(Plot, plot)
+    /// image() creates an Image wrapper
+    WIDGETFN(Image, image)
     /// menubar() creates a MenuBar wrapper
     WIDGETFN(MenuBar, menubar)
     /// sysmenubar() creates a SysMenuBar wrapper
@@ -128,5 +174,37 @@ class DefaultWidgets {
     TreeItem<Message> tree_item(std::string_view label) {
         return TreeItem<Message>(label);
     }
+    /// Build n sibling subtrees with build(i) on the thread pool and return
+    /// them in order. build must only read state, never touch FLTK.
+    template <class F>
+    std::vector<std::shared_ptr<Widget<Message>>>
+    parallel_children(std::size_t n, F &&build) const {
+        std::vector<std::shared_ptr<Widget<Message>>> out(n);
+        auto make = [&](std::size_t first, std::size_t last) {
+            for (auto i = first; i < last; i++) {
+                out[i] = build(i);
+                if (out[i])
+                    out[i]->hash();
+            }
+        };
+        // A few chunks per worker to even out subtrees of different sizes
+        auto &pool  = ThreadPool::global();
+        auto chunks = std::min(n, pool.size() * 4);
+        if (chunks <= 1) {
+            make(0, n);
+            return out;
+        }
+        TaskGroup group(pool);
+        for (std::size_t c = 0; c < chunks; c++)
+            group.run([&, c] { make(n * c / chunks, n * (c + 1) / chunks); });
+        group.wait();
+        return out;
+    }
+    /// Start building a subtree with build() on the thread pool; get() on
+    /// the result joins it. build must only read state, never touch FLTK.
+    template <class F>
+    SpawnedView<Message> spawn_view(F &&build) const {
+        return SpawnedView<Message>(std::forward<F>(build));
+    }
 };
 } // namespace rf::detail